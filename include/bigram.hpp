@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief Number of most frequent terms whose adjacent pairs are indexed as
+ * bigrams.
+ *
+ * Phrases of common terms are the slowest to verify positionally, since they
+ * have many candidate documents and the positions of the common terms must be
+ * scanned in each of them. A phrase with a rarer term has only the few
+ * candidates of that term. Indexing only the pairs of two common terms bounds
+ * the number of distinct bigrams by the square of this count.
+ */
+constexpr size_t COMMON_TERM_COUNT = 128;
+
+/**
+ * @brief Return the key under which the bigram of the given adjacent terms
+ * is stored in the dictionary.
+ *
+ * Terms never contain whitespace, so the key cannot clash with a term.
+ */
+inline std::string bigram_key(const std::string& first,
+                              const std::string& second) {
+    return first + ' ' + second;
+}
+
+/**
+ * @brief Return true if the given term is in the sorted vector of common
+ * terms.
+ */
+inline bool is_common_term(const std::vector<std::string>& common_terms,
+                           const std::string& term) {
+    return std::binary_search(common_terms.begin(), common_terms.end(), term);
+}
+
+/**
+ * @brief Return true if the bigram of the given adjacent terms is indexed,
+ * i.e. if both of the terms are common.
+ *
+ * The posting list of an indexed bigram holds every occurrence of the pair,
+ * each at the position of its first term; if the key of an indexed bigram
+ * is not in a segment, the pair doesn't occur in that segment.
+ */
+inline bool is_indexed_bigram(const std::vector<std::string>& common_terms,
+                              const std::string& first,
+                              const std::string& second) {
+    return is_common_term(common_terms, first) &&
+           is_common_term(common_terms, second);
+}
+} // namespace ir
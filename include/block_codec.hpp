@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ir {
+
+/**
+ * @brief Number of integers in a block packed by ir::pack_block.
+ */
+constexpr size_t BLOCK_SIZE = 128;
+
+/**
+ * @brief Instruction set extensions that can be used to unpack blocks.
+ */
+enum class SimdLevel { Scalar, SSE41, AVX2 };
+
+/**
+ * @brief Return the best instruction set extension supported by the CPU the
+ * program is running on.
+ *
+ * The result is computed once using the CPU feature flags and cached;
+ * ir::unpack_block and ir::prefix_sum_block dispatch to the implementation
+ * for this level.
+ *
+ * @return SimdLevel::AVX2 or SimdLevel::SSE41 if the CPU supports them;
+ * SimdLevel::Scalar, otherwise.
+ */
+SimdLevel simd_level();
+
+/**
+ * @brief Return the number of bits needed to represent the largest of the
+ * given integers.
+ *
+ * @param in Pointer to the integers.
+ * @param count Number of integers.
+ *
+ * @return Integer in [0, 32]. 0 if all the integers are 0.
+ */
+unsigned max_bits(const uint32_t* in, size_t count);
+
+/**
+ * @brief Return the number of bytes ir::pack_block writes for a block whose
+ * integers are packed using the given number of bits.
+ */
+constexpr size_t packed_block_size(unsigned bits) {
+    return BLOCK_SIZE * bits / 8;
+}
+
+/**
+ * @brief Pack ir::BLOCK_SIZE integers using bits bits per integer.
+ *
+ * Integers are stored in a vertical layout of four 32-bit lanes: integer i
+ * belongs to lane i % 4, and each lane is a separate little bit stream whose
+ * 32-bit words are interleaved with the words of the other lanes. This lets
+ * SSE and AVX2 implementations unpack four integers per 128-bit lane with a
+ * shift and a mask, and the scalar implementation read the same format.
+ *
+ * @param in ir::BLOCK_SIZE integers each of which fits into bits bits.
+ * @param bits Number of bits per integer, at most 32.
+ * @param out Output buffer of at least ir::packed_block_size(bits) bytes.
+ */
+void pack_block(const uint32_t* in, unsigned bits, uint8_t* out);
+
+/**
+ * @brief Unpack ir::BLOCK_SIZE integers packed by ir::pack_block using the
+ * implementation for ir::simd_level.
+ *
+ * @param in Packed block of ir::packed_block_size(bits) bytes. The block
+ * doesn't need to be aligned.
+ * @param bits Number of bits per integer used when packing.
+ * @param out Output buffer of ir::BLOCK_SIZE integers.
+ */
+void unpack_block(const uint8_t* in, unsigned bits, uint32_t* out);
+
+/**
+ * @brief Portable implementation of ir::unpack_block.
+ */
+void unpack_block_scalar(const uint8_t* in, unsigned bits, uint32_t* out);
+
+/**
+ * @brief SSE4.1 implementation of ir::unpack_block. Must only be called if
+ * ir::simd_level is at least SimdLevel::SSE41.
+ */
+void unpack_block_sse41(const uint8_t* in, unsigned bits, uint32_t* out);
+
+/**
+ * @brief AVX2 implementation of ir::unpack_block. Must only be called if
+ * ir::simd_level is SimdLevel::AVX2.
+ */
+void unpack_block_avx2(const uint8_t* in, unsigned bits, uint32_t* out);
+
+/**
+ * @brief Replace the ir::BLOCK_SIZE gaps in values by their running sums
+ * starting from base.
+ *
+ * After the call, values[i] = base + gaps[0] + gaps[1] + ... + gaps[i].
+ *
+ * @param values ir::BLOCK_SIZE gaps to convert in-place.
+ * @param base Value preceding the first gap.
+ */
+void prefix_sum_block(uint32_t* values, uint32_t base);
+} // namespace ir
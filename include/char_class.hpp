@@ -0,0 +1,141 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace ir {
+
+/**
+ * @brief Class of the characters separating tokens: space, \\t, \\n, \\v, \\f
+ * and \\r.
+ */
+constexpr uint8_t CHAR_DELIMITER = 1 << 0;
+
+/**
+ * @brief Class of the ASCII digits.
+ */
+constexpr uint8_t CHAR_DIGIT = 1 << 1;
+
+/**
+ * @brief Class of the ASCII letters and digits.
+ */
+constexpr uint8_t CHAR_ALNUM = 1 << 2;
+
+/**
+ * @brief Class of the ASCII uppercase letters.
+ */
+constexpr uint8_t CHAR_UPPER = 1 << 3;
+
+/**
+ * @brief Class of the punctuation characters removed from anywhere in a
+ * token: ' " , < >
+ */
+constexpr uint8_t CHAR_STRIPPED = 1 << 4;
+
+/**
+ * @brief Build the table of the classes of all the byte values.
+ *
+ * The classes agree with the functions of \<cctype\> in the "C" locale, which
+ * is the locale of the programs, so they classify the bytes of non-ASCII
+ * characters as none of the classes.
+ */
+constexpr std::array<uint8_t, 256> make_char_classes() {
+    std::array<uint8_t, 256> classes{};
+    for (char c : {' ', '\t', '\n', '\v', '\f', '\r'}) {
+        classes[static_cast<unsigned char>(c)] |= CHAR_DELIMITER;
+    }
+    for (int c = '0'; c <= '9'; ++c) {
+        classes[c] |= CHAR_DIGIT | CHAR_ALNUM;
+    }
+    for (int c = 'A'; c <= 'Z'; ++c) {
+        classes[c] |= CHAR_ALNUM | CHAR_UPPER;
+        classes[c - 'A' + 'a'] |= CHAR_ALNUM;
+    }
+    for (char c : {'\'', '"', ',', '<', '>'}) {
+        classes[static_cast<unsigned char>(c)] |= CHAR_STRIPPED;
+    }
+    return classes;
+}
+
+/**
+ * @brief Bitwise OR of the classes of each byte value.
+ */
+constexpr std::array<uint8_t, 256> CHAR_CLASSES = make_char_classes();
+
+/**
+ * @brief Return true if the given character belongs to all the given
+ * classes.
+ */
+constexpr bool is_char_class(char c, uint8_t classes) {
+    return (CHAR_CLASSES[static_cast<unsigned char>(c)] & classes) == classes;
+}
+
+/**
+ * @brief Return true if the given character separates tokens.
+ */
+constexpr bool is_delimiter(char c) { return is_char_class(c, CHAR_DELIMITER); }
+
+/**
+ * @brief Return true if the given character is an ASCII digit.
+ */
+constexpr bool is_digit(char c) { return is_char_class(c, CHAR_DIGIT); }
+
+/**
+ * @brief Return true if the given character is an ASCII letter or digit.
+ */
+constexpr bool is_alnum(char c) { return is_char_class(c, CHAR_ALNUM); }
+
+/**
+ * @brief Return the lowercase version of the given character; the character
+ * itself if it is not an ASCII uppercase letter.
+ */
+constexpr char to_lower(char c) {
+    return is_char_class(c, CHAR_UPPER) ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+/**
+ * @brief Convert the ASCII uppercase letters of the given characters to
+ * lowercase in place.
+ *
+ * 16 characters are converted at a time with SSE2, which every x86-64 CPU
+ * supports; the rest are converted with ir::to_lower.
+ *
+ * @param str Characters to convert.
+ * @param size Number of characters.
+ */
+void to_lower(char* str, size_t size);
+
+/**
+ * @brief Return the position of the first delimiter in the given text at or
+ * after pos; the size of the text if there is none.
+ *
+ * 16 characters are classified at a time with SSE2 on x86-64.
+ */
+size_t find_delimiter(std::string_view text, size_t pos);
+
+/**
+ * @brief Return the position of the first character that is not a delimiter
+ * in the given text at or after pos; the size of the text if there is none.
+ *
+ * 16 characters are classified at a time with SSE2 on x86-64.
+ */
+size_t skip_delimiters(std::string_view text, size_t pos);
+} // namespace ir
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -63,19 +64,42 @@ using pos_inv_index =
                        std::vector<std::pair<size_t, std::vector<size_t>>>>;
 
 /**
- * @brief Typedef for a data structure mapping a term to a unique ID.
+ * @brief Typedef for a positional inverted index whose terms are identified by
+ * integer keys rather than strings, such as the IDs of an ir::TermPool.
+ *
+ * Each key is mapped to the same vector of document IDs and positions as in
+ * ir::pos_inv_index.
  */
-using term_id_map = std::unordered_map<std::string, size_t>;
+using id_inv_index = std::unordered_map<uint64_t, pos_inv_index::mapped_type>;
 
 /**
- * @brief Typedef for a data structure mapping ID of a term to vector of
- * <doc_id, pos_vec> pairs.
- *
- * Each term ID is mapped to a vector of pairs. Each pair contains the ID of a
- * document containing this term. The second element of each pair contains the
- * vector of positions where the term occurs in the document.
+ * @brief Dictionary entry of a term locating its posting list in the index
+ * and position files.
  */
-using id_pos_map =
-    std::unordered_map<size_t,
-                       std::vector<std::pair<size_t, std::vector<size_t>>>>;
+struct TermInfo {
+    /**
+     * @brief Unique ID of the term.
+     */
+    size_t id;
+    /**
+     * @brief Number of documents the term occurs in.
+     */
+    size_t doc_count;
+    /**
+     * @brief Byte offset of the posting list of the term in the index file.
+     */
+    size_t offset;
+    /**
+     * @brief Size of the posting list of the term in bytes.
+     */
+    size_t length;
+    /**
+     * @brief Byte offset of the positions of the term in the position file.
+     */
+    size_t pos_offset;
+    /**
+     * @brief Size of the positions of the term in bytes.
+     */
+    size_t pos_length;
+};
 } // namespace ir
@@ -0,0 +1,224 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include "mapped_file.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief Number of terms in a front-coded block of the dictionary.
+ */
+constexpr size_t DICT_BLOCK_SIZE = 16;
+
+/**
+ * @brief Encode a sorted dictionary and append the resulting bytes to out.
+ *
+ * Terms are grouped into blocks of ir::DICT_BLOCK_SIZE terms. Within a block
+ * every term is stored as the length of the prefix it shares with the
+ * previous term followed by the remaining suffix (front coding), so that
+ * consecutive terms with long common prefixes take little space. The first
+ * term of each block is stored in full to allow binary searching the blocks.
+ * The encoded dictionary has the following layout:
+ *
+ * <blockquote>
+ *
+ * <TERM_COUNT> <BLOCK_COUNT> (8 bytes each)\n
+ * <BLOCK_OFFSET> <BLOCK_OFFSET> \f$\dots\f$ <BLOCK_OFFSET> (8 bytes each)\n
+ * <BLOCK> <BLOCK> \f$\dots\f$ <BLOCK>\n
+ *
+ * </blockquote>
+ *
+ * where <BLOCK_OFFSET> is the offset of a block from the beginning of the
+ * first block, and each <BLOCK> is of the form
+ *
+ * <blockquote>
+ *
+ * <POSTING_OFFSET> <POS_OFFSET> (varint each)\n
+ * <ENTRY> <ENTRY> \f$\dots\f$ <ENTRY>\n
+ *
+ * </blockquote>
+ *
+ * <POSTING_OFFSET> and <POS_OFFSET> are the offsets of the posting list of the
+ * first term of the block in the index and position files. Each <ENTRY> is a
+ * sequence of varints
+ *
+ * <blockquote>
+ *
+ * <PREFIX_LEN> <SUFFIX_LEN> <SUFFIX> <DOC_COUNT> <LENGTH> <POS_LENGTH>\n
+ *
+ * </blockquote>
+ *
+ * where <SUFFIX> is the raw bytes of the suffix. The ID of a term is its rank
+ * in the sorted order and the posting lists of consecutive terms are adjacent
+ * in the index and position files, so neither the ID nor the offsets of the
+ * remaining terms of a block need to be stored.
+ *
+ * @param terms Terms sorted in increasing order.
+ * @param term_infos Entry of each term. The ID of the i-th entry must be i and
+ * the posting list of each term must directly follow the posting list of the
+ * previous term.
+ * @param out Byte vector the encoded dictionary is appended to.
+ */
+void encode_dictionary(const std::vector<std::string>& terms,
+                       const std::vector<TermInfo>& term_infos,
+                       std::vector<uint8_t>& out);
+
+class DictionaryCursor;
+
+/**
+ * @brief Read-only sorted dictionary from terms to their entries.
+ *
+ * Dictionary memory maps the dictionary file written by ir::IndexWriter
+ * and answers lookups in-place; no term is copied to the heap. A lookup binary
+ * searches the first terms of the blocks and then decodes a single block.
+ *
+ * Since terms are sorted, Dictionary also supports ordered iteration and
+ * range queries via DictionaryCursor.
+ */
+class Dictionary {
+  public:
+    /**
+     * @brief Default constructor that constructs an empty dictionary.
+     */
+    Dictionary() = default;
+
+    /**
+     * @brief Map the dictionary file at the given path.
+     *
+     * @param path Path of a dictionary written by ir::IndexWriter.
+     *
+     * @throws std::runtime_error If the file cannot be mapped or is not a
+     * valid dictionary file.
+     */
+    explicit Dictionary(const std::string& path);
+
+    /**
+     * @brief Return the number of terms in the dictionary.
+     */
+    size_t size() const { return m_term_count; }
+
+    /**
+     * @brief Find the entry of the given term.
+     *
+     * @param term Term to look up.
+     * @param info Entry of the term, if found. Otherwise, it is unchanged.
+     *
+     * @return true if the term exists in the dictionary; false, otherwise.
+     */
+    bool find(const std::string& term, TermInfo& info) const;
+
+    /**
+     * @brief Return the entry of the given term.
+     *
+     * @throws std::out_of_range If the term doesn't exist in the dictionary.
+     */
+    TermInfo at(const std::string& term) const;
+
+    /**
+     * @brief Return a cursor pointing to the first term in the dictionary.
+     */
+    DictionaryCursor begin() const;
+
+    /**
+     * @brief Return a cursor pointing to the first term that is not less than
+     * the given term.
+     *
+     * Iterating such a cursor while its term starts with a prefix gives all
+     * the terms with that prefix.
+     */
+    DictionaryCursor lower_bound(const std::string& term) const;
+
+  private:
+    friend class DictionaryCursor;
+
+    /**
+     * @brief Return the index of the last block whose first term is not
+     * greater than the given term, or 0 if there is no such block.
+     */
+    size_t find_block(const std::string& term) const;
+
+    /**
+     * @brief Return a pointer to the beginning of the block with the given
+     * index.
+     */
+    const uint8_t* block(size_t index) const {
+        return m_blocks + m_block_offsets[index];
+    }
+
+  private:
+    MappedFile m_file;
+    size_t m_term_count = 0;
+    size_t m_block_count = 0;
+    const uint64_t* m_block_offsets = nullptr;
+    const uint8_t* m_blocks = nullptr;
+};
+
+/**
+ * @brief Class to iterate the terms of a Dictionary in increasing order.
+ *
+ * @code
+ * for (auto cursor = dict.begin(); cursor.valid(); cursor.next()) {
+ *     use(cursor.term(), cursor.info());
+ * }
+ * @endcode
+ */
+class DictionaryCursor {
+  public:
+    /**
+     * @brief Construct a cursor pointing to the first term of the block with
+     * the given index. If the index is past the last block, the cursor is
+     * invalid.
+     */
+    DictionaryCursor(const Dictionary& dict, size_t block);
+
+    /**
+     * @brief Return true if the cursor points to a term; false if all the
+     * terms have been consumed.
+     */
+    bool valid() const { return m_info.id < m_dict->m_term_count; }
+
+    /**
+     * @brief Return the current term.
+     */
+    const std::string& term() const { return m_term; }
+
+    /**
+     * @brief Return the entry of the current term.
+     */
+    const TermInfo& info() const { return m_info; }
+
+    /**
+     * @brief Move to the next term.
+     */
+    void next();
+
+  private:
+    void decode_entry();
+
+  private:
+    const Dictionary* m_dict;
+    const uint8_t* m_ptr;
+    std::string m_term;
+    TermInfo m_info;
+};
+} // namespace ir
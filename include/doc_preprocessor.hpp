@@ -17,6 +17,7 @@
 #pragma once
 
 #include "defs.hpp"
+#include <string_view>
 
 namespace ir {
 /**
@@ -31,6 +32,10 @@ namespace ir {
  * only the last element of the sequence is replaced by the ASCII character and
  * the rest is replaced with space character.
  *
+ * The document is converted in a single scan that jumps from one '&' to the
+ * next. Each sequence of the original document is converted once; i.e. the
+ * '&' produced by "&amp;" never starts another sequence.
+ *
  * Currently, the replaced character sequences and their replace value is as
  * follows:
  *
@@ -53,4 +58,16 @@ namespace ir {
  * @param doc Raw document.
  */
 void convert_html_special_chars(raw_doc& doc);
+
+/**
+ * @brief Append the given text to out converting the special HTML character
+ * sequences as ir::convert_html_special_chars does.
+ *
+ * This lets a document be converted while it is copied out of its data file
+ * instead of traversing the copy once more.
+ *
+ * @param text Text to convert.
+ * @param out String the converted text is appended to.
+ */
+void convert_html_special_chars(std::string_view text, raw_doc& out);
 } // namespace ir
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief Number of low bits of a document ID addressed within a chunk of a
+ * DocSet. Documents whose IDs share the remaining high bits are stored in
+ * the same chunk.
+ */
+constexpr size_t DOC_SET_CHUNK_BITS = 16;
+
+/**
+ * @brief Maximum number of documents of a chunk stored as a sorted array;
+ * chunks with more documents are stored as bitmaps.
+ *
+ * A bitmap of a chunk takes \f$2^{16}\f$ bits, i.e. as many bytes as an array
+ * of this many 2 byte integers, so each chunk is stored in the smaller form.
+ */
+constexpr size_t ARRAY_CONTAINER_MAX = 4096;
+
+/**
+ * @brief Return true if a DocSet of the given documents would contain at
+ * least one bitmap chunk, i.e. if the documents are dense enough for
+ * bitmap intersections to pay off.
+ *
+ * @param doc_ids Document IDs in increasing order.
+ */
+bool is_dense(const std::vector<size_t>& doc_ids);
+
+/**
+ * @brief Encode the given set of document IDs as a DocSet and append the
+ * resulting bytes to out.
+ *
+ * Documents are grouped into chunks by ID as in Roaring bitmaps. The set has
+ * the following layout:
+ *
+ * <blockquote>
+ *
+ * <CHUNK_COUNT> (4 bytes)\n
+ * <CHUNK_ENTRY> <CHUNK_ENTRY> \f$\dots\f$ <CHUNK_ENTRY>\n
+ * <CONTAINER> <CONTAINER> \f$\dots\f$ <CONTAINER>\n
+ *
+ * </blockquote>
+ *
+ * Each <CHUNK_ENTRY> consists of three little endian 4 byte integers
+ *
+ * <blockquote>
+ *
+ * <KEY> <CARDINALITY> <OFFSET>\n
+ *
+ * </blockquote>
+ *
+ * where <KEY> is the document ID shifted right by ir::DOC_SET_CHUNK_BITS,
+ * <CARDINALITY> is the number of documents in the chunk and <OFFSET> is the
+ * offset of its container from the first container. Entries are sorted by
+ * key. A chunk with at most ir::ARRAY_CONTAINER_MAX documents is stored as a
+ * sorted array of the low bits of the IDs, each a little endian 2 byte
+ * integer; a larger chunk is stored as a bitmap of little endian 8 byte
+ * words.
+ *
+ * @param doc_ids Document IDs in increasing order.
+ * @param out Byte vector the set is appended to.
+ */
+void encode_doc_set(const std::vector<size_t>& doc_ids,
+                    std::vector<uint8_t>& out);
+
+/**
+ * @brief Read-only view over a set of document IDs encoded by
+ * ir::encode_doc_set.
+ *
+ * DocSet does not own its data; it points into the memory mapped index file.
+ * Membership tests take a binary search over the chunk entries followed by a
+ * single bit test or a binary search in a small array, and intersections of
+ * bitmap chunks AND 64 documents at a time.
+ */
+class DocSet {
+  public:
+    DocSet() = default;
+
+    /**
+     * @brief Construct a view over a set encoded by ir::encode_doc_set
+     * starting at begin.
+     */
+    explicit DocSet(const uint8_t* begin);
+
+    /**
+     * @brief Return true if the view points to a set.
+     */
+    bool valid() const { return m_entries != nullptr; }
+
+    /**
+     * @brief Return true if the set contains the given document.
+     */
+    bool contains(size_t doc_id) const;
+
+    /**
+     * @brief Return the IDs of the documents contained in all the given sets.
+     *
+     * @param sets Sets to intersect; at least one.
+     *
+     * @return std::vector of document IDs in increasing order.
+     */
+    static std::vector<size_t> intersect(const std::vector<DocSet>& sets);
+
+  private:
+    /**
+     * @brief Return the index of the chunk with the given key, or the number
+     * of chunks if there is no such chunk.
+     */
+    size_t find_chunk(uint32_t key) const;
+
+    /**
+     * @brief Return true if the given chunk contains a document with the
+     * given low bits.
+     */
+    bool chunk_contains(size_t chunk, uint32_t low) const;
+
+    uint32_t key(size_t chunk) const;
+    uint32_t cardinality(size_t chunk) const;
+    const uint8_t* container(size_t chunk) const;
+
+    const uint8_t* m_entries = nullptr;
+    const uint8_t* m_containers = nullptr;
+    size_t m_chunk_count = 0;
+};
+} // namespace ir
@@ -17,6 +17,10 @@
 #pragma once
 
 #include "defs.hpp"
+#include "dictionary.hpp"
+#include "index_reader.hpp"
+#include "segment.hpp"
+#include "term_hash.hpp"
 #include <string>
 #include <vector>
 
@@ -32,25 +36,54 @@ const std::string DATASET_DIR = "Dataset";
  */
 const std::string STOPWORD_PATH = "stopwords.txt";
 /**
- * @brief Relative path from executable to the dictionary built by indexer and
- * used by searcher.
+ * @brief Relative path from executable to the directory holding the segments
+ * of the index built by indexer and used by searcher.
  */
-const std::string DICT_PATH = "dict.txt";
+const std::string INDEX_DIR = "index";
 /**
- * @brief Relative path from executable to the positional inverted index built
- * by indexer and used by searcher.
+ * @brief Relative path from executable to the manifest listing the segments
+ * of the index.
  */
-const std::string INDEX_PATH = "index.txt";
+const std::string MANIFEST_PATH = INDEX_DIR + "/manifest.txt";
 /**
- * @brief Tag to use to denote posting list sequence has started in the index
- * file.
+ * @brief Name of the dictionary file in a segment directory.
  */
-const std::string POS_LIST_BEG_TAG = "<POS_LIST>";
+const std::string DICT_FILE = "dict.bin";
 /**
- * @brief Tag to use to denote posting list sequence has enden in the index
- * file.
+ * @brief Name of the file holding the document streams of the posting lists
+ * in a segment directory.
  */
-const std::string POS_LIST_END_TAG = "</POS_LIST>";
+const std::string INDEX_FILE = "index.bin";
+/**
+ * @brief Magic bytes at the beginning of the binary index file identifying its
+ * format and version.
+ */
+const std::string INDEX_MAGIC = "IRPOSIX7";
+/**
+ * @brief Name of the file holding the position streams of the posting lists
+ * in a segment directory.
+ */
+const std::string POSITIONS_FILE = "positions.bin";
+/**
+ * @brief Magic bytes at the beginning of the binary position file identifying
+ * its format and version.
+ */
+const std::string POSITIONS_MAGIC = "IRPOSNS1";
+/**
+ * @brief Magic bytes at the beginning of the binary dictionary file
+ * identifying its format and version. Its length must be a multiple of 8.
+ */
+const std::string DICT_MAGIC = "IRDICT02";
+/**
+ * @brief Name of the minimal perfect hash of the vocabulary in a segment
+ * directory.
+ */
+const std::string TERM_HASH_FILE = "terms.mph";
+/**
+ * @brief Magic bytes at the beginning of the term hash file identifying its
+ * format and version. Its length must be a multiple of 8.
+ */
+const std::string TERM_HASH_MAGIC = "IRMPHF02";
 
 /**
  * @brief Return a list of filepaths of unzipped Reuters data files under
@@ -67,84 +100,127 @@ const std::string POS_LIST_END_TAG = "</POS_LIST>";
 std::vector<std::string> get_data_file_list();
 
 /**
- * @brief Form a map of <term : ID> and write it to a file at ir::DICT_PATH.
+ * @brief Return the terms of the given inverted index sorted in increasing
+ * order.
  *
- * Each line of ir::DICT_PATH is of the form
+ * The rank of a term in the returned vector is its ID in the index and the
+ * dictionary files.
  *
- * <blockquote>
+ * @param inverted_index Positional inverted index constructed from the corpus.
  *
- * \<TERM\> : <ID>
+ * @return Sorted vector of all the terms in inverted_index.
+ */
+std::vector<std::string> sorted_terms(const pos_inv_index& inverted_index);
+
+/**
+ * @brief Return the directory of the segment with the given name.
+ */
+std::string segment_dir(const std::string& name);
+
+/**
+ * @brief Read the manifest of the index at ir::MANIFEST_PATH.
  *
- * </blockquote>
+ * The manifest is a text file with one entry per line: <tt>NEXT id</tt> holds
+ * the ID of the next segment, <tt>SEGMENT name doc_count shard</tt> lists a
+ * segment, <tt>FILE path</tt> lists a data file whose documents are in the
+ * index and <tt>COMMON term</tt> lists a common term.
  *
- * where \<TERM\> is a term in the given inverted index and <ID> is a unique ID
- * assigned to \<TERM\>.
+ * @return Manifest of the index; an empty manifest if there is no index yet.
  *
- * @section example Example entries
+ * @throws std::runtime_error If the manifest is invalid.
+ */
+Manifest read_manifest();
+
+/**
+ * @brief Replace the manifest at ir::MANIFEST_PATH with the given manifest.
  *
- * <blockquote>
- * hfl 31932\n
- * t-bond 31933\n
- * miyaji 31934\n
- * micropro 31935\n
- * </blockquote>
+ * The manifest is written to a temporary file which is then renamed, so
+ * readers see either the old or the new manifest.
  *
- * @param inverted_index Positional inverted index constructed from the corpus.
+ * @throws std::runtime_error If the manifest cannot be written.
  */
-void write_dict_file(const pos_inv_index& inverted_index);
+void write_manifest(const Manifest& manifest);
 
 /**
- * @brief Form a map of <ID : list<ID, list<pos>>> and write the resulting index
- * to a file at ir::INDEX_PATH.
+ * @brief Write the positional inverted index as a new segment in the given
+ * directory.
+ *
+ * The posting lists are written with ir::IndexWriter in the order returned
+ * by sorted_terms. The files are designed to be memory mapped and queried
+ * in-place: the index file holds the document streams of the lists, the
+ * position file holds the position streams, and the dictionary and the term
+ * hash locate the list of each term. Hence, queries that need only document
+ * IDs never read positions, and the searcher only touches the parts of the
+ * files that belong to the terms of a query.
+ *
+ * @param dir Segment directory; see segment_dir.
+ * @param inverted_index Positional inverted index constructed from the
+ * documents of the segment.
+ *
+ * @throws std::runtime_error If the segment cannot be written.
+ */
+void write_segment(const std::string& dir, const pos_inv_index& inverted_index);
+
+/**
+ * @brief Delete the files and the directory of the given segment.
  *
- * An entry in ir::INDEX_PATH is of the form
+ * Segments that are already opened by a searcher remain readable until they
+ * are closed.
+ */
+void remove_segment(const std::string& dir);
+
+/**
+ * @brief Open the dictionary of the given segment for lookups.
  *
- * <blockquote>
+ * The dictionary file is memory mapped and not parsed; see ir::Dictionary.
  *
- * <ID>\n
- * <BEGIN_TAG>\n
- * <TAB><DOC_ID> : <POS> <POS> \f$\dots\f$ <POS>\n
- * <TAB><DOC_ID> : <POS> <POS> \f$\dots\f$ <POS>\n
- * \f$\vdots\f$\n
- * <TAB><DOC_ID> : <POS> <POS> \f$\dots\f$ <POS>\n
- * <END_TAG>\n
+ * @param dir Segment directory.
  *
- * </blockquote>
+ * @return Dictionary from terms to their entries.
  *
- * @section example Example entry
+ * @throws std::runtime_error If the dictionary file does not exist or is
+ * invalid.
+ */
+Dictionary read_dict_file(const std::string& dir);
+
+/**
+ * @brief Open the minimal perfect hash of the vocabulary of the given segment
+ * for exact term lookups.
  *
- * <blockquote>
+ * The file is memory mapped and not parsed; see ir::TermHash.
  *
- * 63856\n
- * <POS_LIST>\n
- *     18501 : 53 65 79\n
- *     19512 : 82\n
- * </POS_LIST>\n
+ * @param dir Segment directory.
  *
- * </blockquote>
+ * @return Hash table from terms to their entries.
  *
- * @param inverted_index
+ * @throws std::runtime_error If the term hash file does not exist or is
+ * invalid.
  */
-void write_index_file(const pos_inv_index& inverted_index);
+TermHash read_term_hash_file(const std::string& dir);
 
 /**
- * @brief Read the dictionary at ir::DICT_PATH and return it.
+ * @brief Open the index and position files of the given segment for
+ * querying.
+ *
+ * The index files are memory mapped and not parsed; see ir::IndexReader.
  *
- * Dictionary file is parsed according to the specification given in the
- * documentation of write_dict_file.
+ * @param dir Segment directory.
  *
- * @return Dictionary from term to IDs.
+ * @return Reader giving access to the posting list of each dictionary entry.
+ *
+ * @throws std::runtime_error If the index files do not exist or are invalid.
  */
-term_id_map read_dict_file();
+IndexReader read_index_file(const std::string& dir);
 
 /**
- * @brief Read the index at ir::INDEX_PATH and return it.
+ * @brief Open every segment listed in the given manifest for querying.
+ *
+ * @param manifest Manifest as returned by read_manifest.
  *
- * Index file is parsed according to the specification given in the
- * documentation of write_index_file.
+ * @return Opened segments of the index.
  *
- * @return Index from term ID to a vector of document IDs and positions in
- * documents.
+ * @throws std::runtime_error If there is no index or one of its segments
+ * cannot be opened.
  */
-id_pos_map read_index_file();
+std::vector<IndexSegment> read_index(const Manifest& manifest);
 } // namespace ir
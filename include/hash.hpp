@@ -0,0 +1,75 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ir {
+
+/**
+ * @brief Mix the bits of the given integer so that every input bit affects
+ * every output bit.
+ *
+ * This is the finalizer of MurmurHash3 for 64-bit integers.
+ */
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+/**
+ * @brief Compute a 64-bit hash of the given byte sequence.
+ *
+ * Bytes are consumed 8 at a time and combined using multiplications and
+ * rotations; the result is finalized by ir::mix64. The hash is not
+ * cryptographic, but different seeds give independent looking hash
+ * functions, which is what hash tables and perfect hash functions need.
+ *
+ * @param data Pointer to the bytes to hash.
+ * @param len Number of bytes.
+ * @param seed Seed selecting the hash function.
+ *
+ * @return 64-bit hash value.
+ */
+inline uint64_t hash_bytes(const char* data, size_t len, uint64_t seed = 0) {
+    constexpr uint64_t mul = 0x9E3779B97F4A7C15ull;
+    uint64_t h = seed ^ (len * mul);
+
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        h ^= mix64(word);
+        h = ((h << 27) | (h >> 37)) * mul;
+    }
+
+    // pack the remaining bytes into a single word
+    uint64_t tail = 0;
+    for (size_t shift = 0; i < len; ++i, shift += 8) {
+        tail |= static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << shift;
+    }
+    h ^= mix64(tail);
+
+    return mix64(h);
+}
+} // namespace ir
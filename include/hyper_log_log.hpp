@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief Sketch estimating the number of distinct items of a stream in
+ * constant memory using the HyperLogLog algorithm.
+ *
+ * Each item is hashed with ir::hash_bytes. The first precision bits of the
+ * hash select one of \f$m = 2^{precision}\f$ registers, which keeps the
+ * largest number of leading zeros plus one seen in the rest of the hash.
+ * The estimate is the normalized harmonic mean of \f$2^{register}\f$ with
+ * linear counting used for small cardinalities. Its relative standard error
+ * is about \f$1.04 / \sqrt{m}\f$, e.g. 0.8% for precision 14, which takes
+ * 16 KiB.
+ */
+class HyperLogLog {
+  public:
+    /**
+     * @brief Smallest supported precision.
+     */
+    static constexpr unsigned MinPrecision = 4;
+    /**
+     * @brief Largest supported precision.
+     */
+    static constexpr unsigned MaxPrecision = 18;
+
+    /**
+     * @brief Construct an empty sketch with 2^precision registers.
+     *
+     * @param precision Number of hash bits selecting a register, clamped to
+     * [HyperLogLog::MinPrecision, HyperLogLog::MaxPrecision]; 0 constructs
+     * a sketch without any registers which ignores all the items.
+     */
+    explicit HyperLogLog(unsigned precision = 0);
+
+    /**
+     * @brief Add the given item to the sketch.
+     */
+    void add(std::string_view item);
+
+    /**
+     * @brief Add the items of the given sketch to this sketch.
+     *
+     * Both sketches must have the same precision.
+     */
+    void merge(const HyperLogLog& other);
+
+    /**
+     * @brief Return the estimated number of distinct items added so far.
+     */
+    double estimate() const;
+
+  private:
+    unsigned m_precision;
+    std::vector<uint8_t> m_registers;
+};
+} // namespace ir
@@ -0,0 +1,241 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include "term_pool.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief Default memory budget of ir::IndexBuilder in bytes.
+ */
+constexpr size_t DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+
+/**
+ * @brief Number of partitions the terms of the in-memory block of
+ * ir::IndexBuilder are hashed into.
+ */
+constexpr size_t INVERSION_PARTITION_COUNT = 16;
+
+class ShardedIndexWriter;
+
+/**
+ * @brief Class to build a segment from documents added one at a time using
+ * bounded memory.
+ *
+ * IndexBuilder implements single-pass in-memory indexing (SPIMI). Postings of
+ * the added documents are accumulated in an in-memory block. When the
+ * estimated size of the block exceeds the memory budget, the block is sorted
+ * by term and spilled to disk as a temporary run, which has the same format
+ * as a segment. IndexBuilder::finish merges the runs into the final segment
+ * with ir::merge_segments, which reads the runs one term at a time. Hence,
+ * peak memory is bounded by the budget plus the vocabulary, regardless of the
+ * number of documents.
+ *
+ * If all the documents fit into the budget, the block is written as the
+ * segment directly.
+ *
+ * Terms arrive as IDs of an ir::TermPool, and the block is keyed by these IDs,
+ * so inverting a document only hashes and compares integers. The strings of
+ * the terms are looked up in the pool when the block is written, which is
+ * the only time they are needed to sort the dictionary.
+ *
+ * Documents can be added from several threads at the same time. The block is
+ * hash partitioned by term into ir::INVERSION_PARTITION_COUNT partitions with
+ * a lock each, and the postings of a document are added to each partition
+ * under a single lock, so threads inverting different documents rarely wait
+ * for each other. Since a document is added to a partition at once, its
+ * postings are appended to the end of the document vectors without any
+ * search; the vectors are sorted by document ID when the block is written.
+ *
+ * The segment can be split into several shards by document ID range. Shards
+ * get the same number of documents and are written in the same pass.
+ *
+ * Besides the terms, the builder indexes the bigrams of adjacent common
+ * terms; see ir::is_indexed_bigram. If no common terms are given, which is
+ * the case when the index is created, no bigrams are indexed while the
+ * documents are added. Instead, IndexBuilder::finish chooses the
+ * ir::COMMON_TERM_COUNT terms with the highest document frequency and finds
+ * their bigrams by merging the positions of the common terms, which are far
+ * fewer than the positions of all the terms.
+ */
+class IndexBuilder {
+  public:
+    /**
+     * @brief Construct a builder keeping its temporary runs next to the given
+     * directory.
+     *
+     * @param dir Segment directory; see ir::segment_dir. Runs are written to
+     * directories with the same name followed by a suffix.
+     * @param memory_budget Approximate maximum size of the in-memory block in
+     * bytes.
+     * @param common_terms Sorted common terms of the index; empty if they
+     * must be chosen from the added documents.
+     * @param term_pool Pool of the terms of the added documents. The pool
+     * must outlive the builder.
+     */
+    IndexBuilder(const std::string& dir, size_t memory_budget,
+                 const std::vector<std::string>& common_terms,
+                 TermPool& term_pool);
+
+    /**
+     * @brief Add the postings of a document.
+     *
+     * This function can be called from several threads concurrently.
+     *
+     * @param doc_id ID of the document. Each document must be added once.
+     * @param terms IDs of the terms of the document in the term pool and
+     * their positions as returned by ir::Tokenizer::get_doc_term_ids.
+     *
+     * @throws std::runtime_error If a run cannot be written.
+     */
+    void add_document(size_t doc_id,
+                      const std::vector<std::pair<uint32_t, size_t>>& terms);
+
+    /**
+     * @brief Return the number of documents added so far.
+     */
+    size_t doc_count() const {
+        std::lock_guard<std::mutex> lock(m_doc_mutex);
+        return m_doc_ids.size();
+    }
+
+    /**
+     * @brief Return the sorted common terms whose bigrams are indexed.
+     *
+     * If no common terms were given on construction, they are available
+     * after calling IndexBuilder::finish.
+     */
+    const std::vector<std::string>& common_terms() const {
+        return m_common_terms;
+    }
+
+    /**
+     * @brief Write the added documents as one segment per shard and delete
+     * the temporary runs.
+     *
+     * The documents are split into as many contiguous ranges of document IDs
+     * as there are shard directories, each holding the same number of
+     * documents up to one.
+     *
+     * @param dirs Segment directory of each shard; at most doc_count()
+     * directories so that no shard is empty.
+     *
+     * @return Number of documents in each shard.
+     *
+     * @throws std::runtime_error If a segment cannot be written.
+     */
+    std::vector<size_t> finish(const std::vector<std::string>& dirs);
+
+  private:
+    /**
+     * @brief Partition of the in-memory block.
+     */
+    struct Partition {
+        id_inv_index block;
+        std::mutex mutex;
+    };
+
+    /**
+     * @brief Return true if the term with the given ID is a common term.
+     */
+    bool is_common_id(uint32_t term_id) const;
+
+    /**
+     * @brief Return the dictionary key of the given key of the in-memory
+     * block, i.e. the term or the bigram it stands for.
+     */
+    std::string key_string(uint64_t key) const;
+
+    /**
+     * @brief Occurrence of a term given by its document ID, position and ID
+     * in the term pool, in this order so that occurrences sort by position.
+     */
+    using occurrence = std::tuple<size_t, size_t, uint32_t>;
+
+    /**
+     * @brief Look up the IDs of the common terms in the term pool.
+     */
+    void intern_common_terms();
+
+    /**
+     * @brief Write the in-memory block in increasing order of term with the
+     * given writer, finish the writer and clear the block.
+     *
+     * @param writer Writer of the block.
+     */
+    void write_block(ShardedIndexWriter& writer);
+
+    /**
+     * @brief Write the in-memory block as a new run and clear it.
+     *
+     * No documents may be added concurrently.
+     */
+    void spill();
+
+    /**
+     * @brief Choose the common terms among the terms of the in-memory block
+     * and the runs.
+     */
+    void choose_common_terms();
+
+    /**
+     * @brief Add the bigrams of adjacent common terms of all the added
+     * documents to the in-memory block.
+     *
+     * The positions of the common terms are read from the block and from
+     * each run in turn. The block is spilled when it exceeds the budget.
+     */
+    void add_common_bigrams();
+
+    /**
+     * @brief Add the bigrams formed by the given occurrences of common terms
+     * to the in-memory block.
+     *
+     * @param occurrences Occurrences of the common terms in some documents;
+     * all the occurrences of the common terms in these documents must be
+     * given. The vector is sorted.
+     */
+    void add_bigrams(std::vector<occurrence>& occurrences);
+
+    std::string m_dir;
+    size_t m_memory_budget;
+    std::atomic<size_t> m_memory_used;
+    std::vector<std::string> m_common_terms;
+    // sorted IDs of the common terms in the term pool
+    std::vector<uint32_t> m_common_ids;
+    bool m_choose_common_terms;
+    TermPool& m_term_pool;
+    std::vector<size_t> m_doc_ids;
+    mutable std::mutex m_doc_mutex;
+    // shared while documents are added; exclusive while the block is spilled
+    std::shared_timed_mutex m_block_mutex;
+    std::vector<std::unique_ptr<Partition>> m_partitions;
+    std::vector<std::string> m_runs;
+};
+} // namespace ir
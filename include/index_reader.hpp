@@ -0,0 +1,74 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include "mapped_file.hpp"
+#include "posting_list.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ir {
+
+/**
+ * @brief Class to access the binary positional inverted index written by
+ * ir::IndexWriter without loading it to memory.
+ *
+ * IndexReader memory maps the index and position files and hands out
+ * PostingList views pointing directly into the mappings. The files are mapped
+ * for random access, so opening an index only reads its headers and each
+ * query pages in only the posting lists of its terms, as located by their
+ * dictionary entries. Positions are paged in only if they are decoded.
+ */
+class IndexReader {
+  public:
+    /**
+     * @brief Default constructor that constructs a reader of an empty index.
+     */
+    IndexReader() = default;
+
+    /**
+     * @brief Map the index and position files at the given paths.
+     *
+     * @param path Path of a binary index written by ir::IndexWriter.
+     * @param pos_path Path of the position file written together with the
+     * index.
+     *
+     * @throws std::runtime_error If a file cannot be mapped or is not a valid
+     * index or position file.
+     */
+    IndexReader(const std::string& path, const std::string& pos_path);
+
+    /**
+     * @brief Return the posting list of the term with the given dictionary
+     * entry.
+     *
+     * @param info Dictionary entry of the term.
+     *
+     * @return View over the posting list of the term.
+     *
+     * @throws std::out_of_range If the entry points outside the index or
+     * position file.
+     */
+    PostingList postings(const TermInfo& info) const;
+
+  private:
+    MappedFile m_file;
+    MappedFile m_pos_file;
+};
+} // namespace ir
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief Class to write the files of an index segment one posting list at a
+ * time.
+ *
+ * IndexWriter appends the posting list of each term to the index and position
+ * files of a segment directory as soon as it is added, so only the vocabulary
+ * is kept in memory. Terms must be added in increasing order. When
+ * IndexWriter::finish is called, the dictionary and the term hash of the
+ * segment are written from the vocabulary.
+ *
+ * The files of a segment are laid out as described in the documentation of
+ * ir::encode_posting_list, ir::encode_dictionary and ir::encode_term_hash,
+ * each preceded by its magic bytes defined in file_manager.hpp.
+ */
+class IndexWriter {
+  public:
+    /**
+     * @brief Create the index files of a new segment in the given directory.
+     *
+     * The directory is created if it doesn't exist.
+     *
+     * @param dir Segment directory.
+     *
+     * @throws std::runtime_error If the directory or the files cannot be
+     * created.
+     */
+    explicit IndexWriter(const std::string& dir);
+
+    /**
+     * @brief Append the posting list of the given term.
+     *
+     * @param term Term greater than all the previously added terms.
+     * @param doc_vec Vector of <doc_id, pos_vec> pairs sorted by doc_id, each
+     * pos_vec sorted in increasing order.
+     */
+    void
+    add(const std::string& term,
+        const std::vector<std::pair<size_t, std::vector<size_t>>>& doc_vec);
+
+    /**
+     * @brief Return the number of terms added so far.
+     */
+    size_t term_count() const { return m_terms.size(); }
+
+    /**
+     * @brief Flush the index files and write the dictionary and the term hash
+     * of the segment.
+     *
+     * No terms can be added after calling this function.
+     *
+     * @throws std::runtime_error If a file cannot be written.
+     */
+    void finish();
+
+  private:
+    std::string m_dir;
+    std::ofstream m_index;
+    std::ofstream m_positions;
+    size_t m_offset;
+    size_t m_pos_offset;
+
+    std::vector<std::string> m_terms;
+    std::vector<TermInfo> m_term_infos;
+    std::vector<uint8_t> m_doc_buffer;
+    std::vector<uint8_t> m_pos_buffer;
+};
+
+/**
+ * @brief Class to write posting lists to several segments partitioned by
+ * document ID range.
+ *
+ * The postings of each added term are split at the given document IDs and
+ * each part is written to the segment of its range with an ir::IndexWriter.
+ * Since ranges are contiguous, the shards can be searched independently and
+ * their results concatenated in order of shard.
+ */
+class ShardedIndexWriter {
+  public:
+    /**
+     * @brief Create the index files of a new segment in each of the given
+     * directories.
+     *
+     * @param dirs Segment directory of each shard in increasing order of
+     * document IDs.
+     * @param shard_begins First document ID of each shard except the first
+     * one in increasing order; its size must be one less than the size of
+     * dirs.
+     *
+     * @throws std::runtime_error If a segment cannot be created.
+     */
+    ShardedIndexWriter(const std::vector<std::string>& dirs,
+                       const std::vector<size_t>& shard_begins);
+
+    /**
+     * @brief Append the posting list of the given term to each shard
+     * containing one of its documents.
+     *
+     * @param term Term greater than all the previously added terms.
+     * @param doc_vec Vector of <doc_id, pos_vec> pairs sorted by doc_id, each
+     * pos_vec sorted in increasing order.
+     */
+    void
+    add(const std::string& term,
+        const std::vector<std::pair<size_t, std::vector<size_t>>>& doc_vec);
+
+    /**
+     * @brief Finish the segment of each shard; see IndexWriter::finish.
+     *
+     * @throws std::runtime_error If a file cannot be written.
+     */
+    void finish();
+
+  private:
+    std::vector<IndexWriter> m_writers;
+    std::vector<size_t> m_shard_begins;
+    std::vector<std::pair<size_t, std::vector<size_t>>> m_part;
+};
+} // namespace ir
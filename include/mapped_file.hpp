@@ -0,0 +1,100 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace ir {
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * MappedFile maps the file at the given path into the address space of the
+ * process using the POSIX mmap API and unmaps it when the object is
+ * destroyed. The contents are accessed in-place; nothing is copied to the
+ * heap. Pages are loaded by the operating system only when they are touched.
+ *
+ * MappedFile is movable but not copyable.
+ */
+class MappedFile {
+  public:
+    /**
+     * @brief Expected order of accesses to the mapping, passed to the
+     * operating system as a hint to tune read-ahead.
+     */
+    enum class AccessPattern {
+        /**
+         * @brief No particular order; use the default read-ahead.
+         */
+        Normal,
+        /**
+         * @brief The file is read from the beginning to the end.
+         */
+        Sequential,
+        /**
+         * @brief Small parts of the file are accessed in no particular order;
+         * only the touched pages should be read.
+         */
+        Random
+    };
+
+    /**
+     * @brief Default constructor that constructs an empty mapping.
+     */
+    MappedFile() = default;
+
+    /**
+     * @brief Map the file at the given path.
+     *
+     * @param path Path of the file to map.
+     * @param pattern Expected access pattern of the mapping.
+     *
+     * @throws std::runtime_error If the file cannot be opened or mapped.
+     */
+    explicit MappedFile(const std::string& path,
+                        AccessPattern pattern = AccessPattern::Normal);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /**
+     * @brief Unmap the file.
+     */
+    ~MappedFile();
+
+    /**
+     * @brief Return a pointer to the beginning of the mapped contents.
+     */
+    const char* data() const { return m_data; }
+
+    /**
+     * @brief Return the size of the mapped file in bytes.
+     */
+    size_t size() const { return m_size; }
+
+  private:
+    void unmap();
+
+  private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+};
+} // namespace ir
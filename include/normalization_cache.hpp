@@ -0,0 +1,115 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "term_pool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief Default number of tokens kept by a ir::NormalizationCache.
+ */
+constexpr size_t DEFAULT_NORMALIZATION_CACHE_SIZE = 16 * 1024;
+
+/**
+ * @brief Bounded cache from tokens to their normalized terms.
+ *
+ * The cache is an open addressing hash table with linear probing that is
+ * never more than half full. Once it holds its capacity, new tokens are no
+ * longer inserted and existing entries are never evicted. Since token
+ * frequencies follow Zipf's law, the most frequent tokens are seen early and
+ * stay in the cache, which is enough to answer most lookups.
+ *
+ * The table is allocated on the first insertion, so an unused cache is
+ * cheap to construct.
+ */
+class NormalizationCache {
+  public:
+    /**
+     * @brief Construct an empty cache holding at most the given number of
+     * tokens.
+     *
+     * @param capacity Maximum number of tokens; 0 disables the cache.
+     */
+    explicit NormalizationCache(
+        size_t capacity = DEFAULT_NORMALIZATION_CACHE_SIZE);
+
+    /**
+     * @brief Return true if the cache can hold any tokens.
+     */
+    bool enabled() const { return m_capacity > 0; }
+
+    /**
+     * @brief Return the number of tokens in the cache.
+     */
+    size_t size() const { return m_size; }
+
+    /**
+     * @brief Cached normalization of a token.
+     */
+    struct Entry {
+        /**
+         * @brief Normalized term of the token; empty if the token is a
+         * stopword.
+         */
+        std::string term;
+        /**
+         * @brief ID of the term in an ir::TermPool; ir::NO_TERM_ID if the
+         * token is a stopword or the terms are not interned.
+         */
+        uint32_t term_id = NO_TERM_ID;
+    };
+
+    /**
+     * @brief Return a pointer to the entry of the given token; nullptr if the
+     * token is not in the cache.
+     *
+     * The pointer is valid until the next insertion.
+     */
+    const Entry* find(std::string_view token) const;
+
+    /**
+     * @brief Insert the given token and its normalized term if the token is
+     * not empty and the cache is not full.
+     *
+     * @param token Token that is not in the cache.
+     * @param term Normalized term of token; empty if token is a stopword.
+     * @param term_id ID of term; see NormalizationCache::Entry.
+     */
+    void insert(std::string_view token, std::string_view term,
+                uint32_t term_id = NO_TERM_ID);
+
+  private:
+    /**
+     * @brief Slot of the hash table; free if its token is empty.
+     */
+    struct Slot {
+        uint64_t hash = 0;
+        std::string token;
+        Entry entry;
+    };
+
+    size_t m_capacity;
+    size_t m_size = 0;
+    std::vector<Slot> m_slots;
+};
+} // namespace ir
@@ -17,9 +17,11 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 #include "defs.hpp"
+#include "mapped_file.hpp"
 
 namespace ir {
 
@@ -64,13 +66,92 @@ const std::string BODY_BEG_TAG = "<BODY>";
 const std::string BODY_END_TAG = "</BODY>";
 
 /**
- * @brief Parse a Reuters sgm file from the beginning of the given input stream
- * and return a mapping from document IDS to their raw content.
+ * @brief Document of a Reuters sgm file whose fields are slices of the
+ * mapping of the file.
  *
- * @param ifs Input stream containing a Reuters sgm file.
+ * The slices are valid as long as the ir::DocReader that produced the
+ * document exists.
+ */
+struct DocView {
+    /**
+     * @brief ID of the document obtained from ir::ID_FIELD.
+     */
+    size_t id;
+    /**
+     * @brief Text between ir::TITLE_BEG_TAG and ir::TITLE_END_TAG; empty if
+     * the document has no title.
+     */
+    std::string_view title;
+    /**
+     * @brief Text between ir::BODY_BEG_TAG and ir::BODY_END_TAG; empty if
+     * the document has no body.
+     */
+    std::string_view body;
+
+    /**
+     * @brief Return the document text which is a combination of title and
+     * body of the document.
+     */
+    raw_doc text() const {
+        raw_doc doc;
+        doc.reserve(title.size() + 1 + body.size());
+        doc.append(title).append(1, '\n').append(body);
+        return doc;
+    }
+};
+
+/**
+ * @brief Class to read the documents of a Reuters sgm file one at a time
+ * without copying them.
+ *
+ * DocReader memory maps the whole file and scans the mapping for the tags of
+ * each document. Documents are returned as ir::DocView slices into the
+ * mapping, so reading a document allocates no memory and parsing speed is
+ * bounded by I/O rather than by the allocator. Only the touched pages of the
+ * file are in memory, so a file of any size can be read.
+ *
+ * DocReader is movable but not copyable.
+ */
+class DocReader {
+  public:
+    /**
+     * @brief Map the Reuters sgm file at the given path.
+     *
+     * @param path Path of the file.
+     *
+     * @throws std::runtime_error If the file cannot be opened or mapped.
+     */
+    explicit DocReader(const std::string& path);
+
+    /**
+     * @brief Read the next document of the file.
+     *
+     * @param doc Output document.
+     *
+     * @return true if a document is read; false if there are no more
+     * documents in the file.
+     *
+     * @throws std::invalid_argument If a document doesn't contain
+     * ir::TXT_BEG_TAG and ir::TXT_END_TAG fields.
+     */
+    bool next(DocView& doc);
+
+  private:
+    MappedFile m_file;
+    // unread part of the mapping; always begins at the beginning of a line
+    std::string_view m_rest;
+};
+
+/**
+ * @brief Parse the Reuters sgm file at the given path and return a mapping
+ * from document IDS to their raw content.
+ *
+ * @param path Path of a Reuters sgm file.
  *
  * @return Mapping from document IDs obtained from ir::ID_FIELD to document text
  * which is a combination of title and body of the document.
+ *
+ * @throws std::runtime_error If the file cannot be read.
  */
-raw_doc_index parse_file(std::istream& ifs);
+raw_doc_index parse_file(const std::string& path);
 } // namespace ir
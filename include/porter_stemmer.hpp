@@ -0,0 +1,82 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace ir {
+
+/**
+ * @brief Porter stemmer working in place on a caller owned buffer.
+ *
+ * The stemmer keeps the state of the word being stemmed in its members
+ * rather than in globals, so separate PorterStemmer objects can be used on
+ * different threads at the same time. A word is stemmed without any
+ * allocation; the stemmed word is a prefix of the buffer with possibly a few
+ * characters replaced, since stemming never increases the length of a word.
+ *
+ * The implementation is the reference implementation of Martin Porter
+ * including its points of departure from the published algorithm; member
+ * names follow the reference implementation.
+ */
+class PorterStemmer {
+  public:
+    /**
+     * @brief Stem the lowercase word in the given buffer in place.
+     *
+     * Words of at most two characters are not changed.
+     *
+     * @param word Buffer holding the word.
+     * @param length Number of characters of the word.
+     *
+     * @return Length of the stemmed word at the beginning of the buffer; at
+     * most length.
+     */
+    size_t stem(char* word, size_t length);
+
+    /**
+     * @brief Stem the given lowercase word in place.
+     *
+     * @param word Word to stem; resized to the length of the stemmed word.
+     */
+    void stem(std::string& word) { word.resize(stem(&word[0], word.size())); }
+
+  private:
+    bool cons(int i) const;
+    int m() const;
+    bool vowelinstem() const;
+    bool doublec(int j) const;
+    bool cvc(int i) const;
+    bool ends(const char* s);
+    void setto(const char* s);
+    void r(const char* s);
+    void step1ab();
+    void step1c();
+    void step2();
+    void step3();
+    void step4();
+    void step5();
+
+    // buffer of the word; the word is in b[k0], ..., b[k]
+    char* b = nullptr;
+    int k = 0;
+    int k0 = 0;
+    // general offset into the word
+    int j = 0;
+};
+} // namespace ir
@@ -0,0 +1,267 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "block_codec.hpp"
+#include "doc_set.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief Number of bytes of an entry of the skip table of a posting list.
+ */
+constexpr size_t SKIP_ENTRY_SIZE = 3 * sizeof(uint32_t);
+
+/**
+ * @brief Encode the positional posting list of a term as two separate
+ * streams and append the resulting bytes to doc_out and pos_out.
+ *
+ * The document stream holds the document IDs and term frequencies; the
+ * position stream holds the positions. Queries that only need document IDs,
+ * such as conjunctive queries, never touch the position stream.
+ *
+ * Documents are grouped into blocks of ir::BLOCK_SIZE documents. All the
+ * blocks except the last one are full and bit-packed with ir::pack_block; the
+ * remaining documents are encoded with ir::encode_varint. The document stream
+ * has the following layout:
+ *
+ * <blockquote>
+ *
+ * <HEADER> (varint)\n
+ * [<DOC_SET_LENGTH> (varint) <DOC_SET>]\n
+ * <SKIP> <SKIP> \f$\dots\f$ <SKIP>\n
+ * <BLOCK> <BLOCK> \f$\dots\f$ <BLOCK>\n
+ * <TAIL>\n
+ *
+ * </blockquote>
+ *
+ * <HEADER> holds the number of documents shifted left by one; its lowest bit
+ * is set if the list is dense according to ir::is_dense. Only dense lists
+ * store their document IDs once more as a <DOC_SET> encoded by
+ * ir::encode_doc_set, so that they can be intersected with bitmap operations
+ * and probed in constant time.
+ *
+ * There is one <SKIP> entry per full block and one more for <TAIL>; if there
+ * are no full blocks, the skip table is omitted. Each <SKIP> entry consists of
+ * three little endian 4 byte integers
+ *
+ * <blockquote>
+ *
+ * <LAST_DOC_ID> <DOC_OFFSET> <POS_OFFSET>\n
+ *
+ * </blockquote>
+ *
+ * where <LAST_DOC_ID> is the ID of the last document in the block, and
+ * <DOC_OFFSET> and <POS_OFFSET> are the offsets of the block from the first
+ * block in the document stream and from the beginning of the position
+ * stream. The entry of <TAIL> holds the ID of the last document in the list.
+ * The fixed size entries let ir::PostingCursor::advance search the skip table
+ * and jump to the block that may contain a document without decoding the
+ * blocks in between. Each <BLOCK> is of the form
+ *
+ * <blockquote>
+ *
+ * <DOC_BITS> <TF_BITS> (1 byte each)\n
+ * <DOC_GAPS> (ir::packed_block_size(DOC_BITS) bytes)\n
+ * <TFS> (ir::packed_block_size(TF_BITS) bytes)\n
+ *
+ * </blockquote>
+ *
+ * <DOC_GAPS> holds the difference between the ID of each document and the ID
+ * of the previous document, and <TFS> holds the number of positions of each
+ * document minus one.
+ *
+ * <TAIL> holds the remaining documents, each as a pair of varints:
+ *
+ * <blockquote>
+ *
+ * <DOC_GAP> <POS_COUNT>\n
+ *
+ * </blockquote>
+ *
+ * The position stream holds the positions of each block, followed by the
+ * positions of the tail. The position gaps of all documents in a block (or in
+ * the tail) form a single sequence stored as
+ *
+ * <blockquote>
+ *
+ * <POS_CHUNK> <POS_CHUNK> \f$\dots\f$ <POS_CHUNK> <POS_GAP> \f$\dots\f$
+ * <POS_GAP>\n
+ *
+ * </blockquote>
+ *
+ * Every full group of ir::BLOCK_SIZE gaps is stored as a <POS_CHUNK>, which is
+ * a byte holding the bit width followed by the packed gaps; the remaining gaps
+ * are varints. Position gaps are taken within each document, i.e. the first
+ * gap of a document is its first position. The positions of a document are
+ * located by summing the term frequencies of the preceding documents in its
+ * block, so no per-document offsets need to be stored.
+ *
+ * @param doc_vec Vector of <doc_id, pos_vec> pairs sorted by doc_id, each
+ * pos_vec sorted in increasing order.
+ * @param doc_out Byte vector the document stream is appended to.
+ * @param pos_out Byte vector the position stream is appended to.
+ */
+void encode_posting_list(
+    const std::vector<std::pair<size_t, std::vector<size_t>>>& doc_vec,
+    std::vector<uint8_t>& doc_out, std::vector<uint8_t>& pos_out);
+
+/**
+ * @brief Read-only view over the encoded positional posting list of a term.
+ *
+ * PostingList does not own its data; it points into the memory mapped index
+ * and position files. Use PostingCursor to decode its postings.
+ */
+class PostingList {
+  public:
+    PostingList() = default;
+
+    /**
+     * @brief Construct a view over a list encoded by ir::encode_posting_list
+     * whose document stream occupies the range [begin, end) and whose position
+     * stream starts at pos_begin.
+     */
+    PostingList(const uint8_t* begin, const uint8_t* end,
+                const uint8_t* pos_begin);
+
+    /**
+     * @brief Return the number of documents in the posting list.
+     */
+    size_t size() const { return m_size; }
+
+    /**
+     * @brief Return the document set of the list; it is valid only if the
+     * list is dense.
+     */
+    const DocSet& doc_set() const { return m_doc_set; }
+
+  private:
+    friend class PostingCursor;
+
+    DocSet m_doc_set;
+    const uint8_t* m_skips = nullptr;
+    const uint8_t* m_end = nullptr;
+    const uint8_t* m_positions = nullptr;
+    size_t m_size = 0;
+};
+
+/**
+ * @brief Class to iterate the postings of a PostingList in increasing order
+ * of document ID.
+ *
+ * PostingCursor decodes one block of document IDs and term frequencies at a
+ * time using ir::unpack_block. PostingCursor::advance uses the skip table of
+ * the list to jump over the blocks that cannot contain the target document
+ * without decoding them. The position stream is not touched until positions
+ * are requested via PostingCursor::positions, and then it is decoded only up
+ * to the current document.
+ *
+ * @code
+ * for (PostingCursor cursor(list); cursor.valid(); cursor.next()) {
+ *     use(cursor.doc_id(), cursor.positions());
+ * }
+ * @endcode
+ */
+class PostingCursor {
+  public:
+    /**
+     * @brief Construct a cursor pointing to the first posting of the list.
+     */
+    explicit PostingCursor(const PostingList& list);
+
+    /**
+     * @brief Return true if the cursor points to a posting; false if all the
+     * postings have been consumed.
+     */
+    bool valid() const { return m_index < m_block_len; }
+
+    /**
+     * @brief Return the ID of the current document.
+     */
+    size_t doc_id() const { return m_doc_ids[m_index]; }
+
+    /**
+     * @brief Return the number of occurrences of the term in the current
+     * document.
+     */
+    size_t term_freq() const {
+        return m_pos_offsets[m_index + 1] - m_pos_offsets[m_index];
+    }
+
+    /**
+     * @brief Move to the next posting.
+     */
+    void next() {
+        if (++m_index == m_block_len) {
+            load_block(m_block + 1);
+        }
+    }
+
+    /**
+     * @brief Move to the first posting whose document ID is not less than
+     * target.
+     *
+     * If the current document ID is already not less than target, the cursor
+     * is not moved. Otherwise, the skip table is searched by galloping from
+     * the current block, so that advancing by a short distance is cheap, and
+     * only the block containing the result is decoded.
+     *
+     * @param target Document ID to advance to.
+     */
+    void advance(size_t target);
+
+    /**
+     * @brief Return the positions of the term in the current document in
+     * increasing order.
+     *
+     * The returned vector is owned by the cursor and is overwritten when
+     * positions of another document are requested.
+     */
+    const std::vector<uint32_t>& positions();
+
+  private:
+    uint32_t skip_last_doc(size_t block) const;
+    void load_block(size_t block);
+    void load_full_block(const uint8_t* ptr, uint32_t base);
+    void load_tail(const uint8_t* ptr, uint32_t base);
+    void decode_pos_gaps(size_t count);
+
+  private:
+    const uint8_t* m_skips;
+    const uint8_t* m_blocks;
+    const uint8_t* m_end;
+    const uint8_t* m_pos_begin;
+    size_t m_block_count;
+    size_t m_tail_len;
+
+    size_t m_block;
+    size_t m_index;
+    size_t m_block_len;
+    std::array<uint32_t, BLOCK_SIZE> m_doc_ids;
+    std::array<uint32_t, BLOCK_SIZE + 1> m_pos_offsets;
+
+    const uint8_t* m_pos_ptr;
+    std::vector<uint32_t> m_pos_gaps;
+    std::vector<uint32_t> m_positions;
+    size_t m_positions_index;
+};
+} // namespace ir
@@ -17,8 +17,11 @@
 #pragma once
 
 #include "defs.hpp"
+#include "segment.hpp"
+#include "thread_pool.hpp"
 #include <algorithm>
 #include <cassert>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -47,12 +50,24 @@ class QueryProcessor {
 
     /**
      * @brief Positional inverted index constructor that constructs a
-     * QueryProcessor by copying the index.
+     * QueryProcessor taking ownership of the segments of the index.
      *
-     * @param dict Dictionary from terms to their unique IDs.
-     * @param index Index from term IDs to positional posting lists.
+     * Posting lists are read directly from the memory mapped segments at the
+     * offsets stored in their dictionaries; they are never copied into the
+     * QueryProcessor and only the lists of the queried terms are touched.
+     *
+     * Each segment holds a disjoint set of documents, so a query is answered
+     * by running it on every segment in parallel and concatenating the
+     * results in order of segment.
+     *
+     * @param segments Segments of the index as returned by ir::read_index.
+     * @param common_terms Sorted common terms of the index whose bigrams are
+     * indexed; see ir::Manifest::common_terms.
+     * @param thread_count Number of threads searching the segments. No
+     * threads are started if it is 1 or there is a single segment.
      */
-    QueryProcessor(const term_id_map& dict, const id_pos_map& index);
+    QueryProcessor(std::vector<IndexSegment> segments,
+                   std::vector<std::string> common_terms, size_t thread_count);
 
     /**
      * @brief Compute the result of a conjunctive query.
@@ -66,10 +81,22 @@ class QueryProcessor {
      * The resulting documents of a conjunctive query contains all the specified
      * words.
      *
+     * Terms are intersected in increasing order of document frequency as
+     * stored in the dictionary, so the order is known before decoding any
+     * posting list. The rarest term drives the intersection and the cursors
+     * of the other terms skip to its documents using the skip tables of their
+     * lists, so the blocks of the longer lists that cannot contain a result
+     * are never decoded.
+     *
+     * Lists of dense terms also store their documents as an ir::DocSet. If
+     * all the terms are dense, their sets are intersected with bitmap ANDs;
+     * otherwise, the candidates of the other terms are probed in the sets of
+     * the dense terms in constant time instead of advancing their cursors.
+     *
      * @param words std::vector of words \f$w_1, w_2, \dots, w_n\f$.
      *
      * @return std::vector of document IDs containing all the words in the
-     * query.
+     * query. The IDs are sorted within each segment, but not across segments.
      */
     std::vector<size_t>
     conjunctive_query(const std::vector<std::string>& words) const;
@@ -90,24 +117,99 @@ class QueryProcessor {
      * @param dists std::vector of distances \f$k_1, k_2, \dots k_{n-1}\f$.
      *
      * @return std::vector of document IDs containing a sequence of words that
-     * matches the given proximity query.
+     * matches the given proximity query. The IDs are sorted within each
+     * segment, but not across segments. No document matches if the number of
+     * words is not one more than the number of distances.
      */
     std::vector<size_t> proximity_query(const std::vector<std::string>& words,
                                         const std::vector<size_t>& dists) const;
 
   private:
+    /**
+     * @brief Look up the dictionary entry of each of the given words in the
+     * given segment.
+     *
+     * Each word is hashed exactly once per query and segment; the entries are
+     * then passed around instead of the words.
+     *
+     * @param segment Segment to search.
+     * @param words std::vector of words to look up.
+     * @param infos Output vector of the entry of each word.
+     *
+     * @return true if all the words exist in the dictionary; false, otherwise.
+     */
+    bool find_terms(const IndexSegment& segment,
+                    const std::vector<std::string>& words,
+                    std::vector<TermInfo>& infos) const;
+
+    /**
+     * @brief Compute the IDs of the documents containing all the terms with
+     * the given entries.
+     *
+     * The lists are intersected by advancing one PostingCursor per term to
+     * the candidate documents; see QueryProcessor::conjunctive_query.
+     *
+     * @param segment Segment containing the terms.
+     * @param infos Dictionary entries of the terms. The vector is reordered.
+     *
+     * @return std::vector of document IDs in increasing order.
+     */
+    std::vector<size_t> intersect_postings(const IndexSegment& segment,
+                                           std::vector<TermInfo>& infos) const;
+
+    /**
+     * @brief Compute the result of a proximity query in the given segment.
+     *
+     * Adjacent words with an indexed bigram are matched with the posting list
+     * of the bigram, which is much shorter than the lists of its terms.
+     * Candidate documents are found by intersecting the bigram lists with the
+     * lists of the remaining words. A phrase of two such words needs no
+     * positional check since the bigram list holds exactly its documents.
+     *
+     * @param segment Segment to search.
+     * @param words std::vector of words as specified in
+     * QueryProcessor::proximity_query.
+     * @param dists std::vector of distances as specified in
+     * QueryProcessor::proximity_query.
+     *
+     * @return std::vector of matching document IDs in increasing order.
+     */
+    std::vector<size_t>
+    segment_proximity_query(const IndexSegment& segment,
+                            const std::vector<std::string>& words,
+                            const std::vector<size_t>& dists) const;
+
+    /**
+     * @brief Run the given search on every segment and concatenate the
+     * results in order of segment.
+     *
+     * Segments are searched on the thread pool if there is one; otherwise,
+     * they are searched one after another on the calling thread.
+     *
+     * @tparam Search Callable taking a const IndexSegment& and returning the
+     * std::vector of matching document IDs in that segment.
+     */
+    template <typename Search>
+    std::vector<size_t> search_segments(Search search) const;
+
     /**
      * @brief Check if the document with the given id contains a proximity query
-     * specified by words and dists vectors.
+     * specified by cursors and dists vectors.
      *
      * This function starts a recursive positional search from every occurrence
-     * of the first word given in words vector. If any of the sequences that
-     * obey the given distances exist in the document, the function retuns true.
+     * of the first word. If any of the sequences that obey the given distances
+     * exist in the document, the function retuns true.
+     *
+     * Cursors are only moved forward with PostingCursor::advance, so checking
+     * the candidate documents in increasing order of ID skips the blocks
+     * without candidates, and positions are decoded only for the candidate
+     * documents.
      *
      * @param doc_id ID of the document to check if it contains the given
      * proximity query.
-     * @param words std::vector of words to search as specified in
-     * QueryProcessor::proximity_query.
+     * @param cursors std::vector of cursors over the posting lists of the
+     * words to search as specified in QueryProcessor::proximity_query. The
+     * cursors must not have moved past doc_id.
      * @param dists std::vector of distances as specified in
      * QueryProcessor::proximity_query.
      *
@@ -115,12 +217,13 @@ class QueryProcessor {
      * given ID; false, otherwise.
      */
     bool contains_proximity_query(size_t doc_id,
-                                  const std::vector<std::string>& words,
+                                  std::vector<PostingCursor>& cursors,
                                   const std::vector<size_t>& dists) const;
 
   private:
-    term_id_map m_dict;
-    id_pos_map m_index;
+    std::vector<IndexSegment> m_segments;
+    std::vector<std::string> m_common_terms;
+    std::unique_ptr<ThreadPool> m_pool;
 };
 
 /**
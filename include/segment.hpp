@@ -0,0 +1,215 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "index_reader.hpp"
+#include "term_hash.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ir {
+
+class ShardedIndexWriter;
+
+/**
+ * @brief Number of segments of the same tier merged into a single segment.
+ *
+ * A segment with \f$n\f$ documents is in tier \f$\lfloor \log_F n \rfloor\f$
+ * where \f$F\f$ is ir::MERGE_FACTOR. Since only segments of the same tier are
+ * merged, every document is rewritten at most once per tier, i.e.
+ * \f$O(\log_F N)\f$ times for \f$N\f$ documents.
+ */
+constexpr size_t MERGE_FACTOR = 4;
+
+/**
+ * @brief Manifest entry of a segment.
+ */
+struct SegmentInfo {
+    /**
+     * @brief Name of the segment directory under ir::INDEX_DIR.
+     */
+    std::string name;
+    /**
+     * @brief Number of documents in the segment.
+     */
+    size_t doc_count;
+    /**
+     * @brief Shard the segment belongs to. Only segments of the same shard
+     * are merged, so the index keeps one segment per shard in the long run.
+     */
+    size_t shard;
+};
+
+/**
+ * @brief List of the segments making up the index and the data files they
+ * were built from.
+ *
+ * Segments are immutable once they are listed in the manifest. The manifest is
+ * the only file that is ever modified, and it is replaced atomically, so the
+ * index on disk is always consistent.
+ */
+struct Manifest {
+    /**
+     * @brief ID of the next segment to create.
+     */
+    size_t next_id = 0;
+    /**
+     * @brief Data files whose documents are in the index.
+     */
+    std::vector<std::string> files;
+    /**
+     * @brief Live segments of the index.
+     */
+    std::vector<SegmentInfo> segments;
+    /**
+     * @brief Sorted common terms whose adjacent pairs are indexed as bigrams;
+     * see ir::COMMON_TERM_COUNT. They are chosen when the index is created
+     * and never change, so every segment indexes the same bigrams.
+     */
+    std::vector<std::string> common_terms;
+};
+
+/**
+ * @brief Opened segment of the index ready for querying.
+ */
+struct IndexSegment {
+    /**
+     * @brief Minimal perfect hash from the terms of the segment to their
+     * entries.
+     */
+    TermHash dict;
+    /**
+     * @brief Reader of the posting lists of the segment.
+     */
+    IndexReader index;
+};
+
+/**
+ * @brief Merge the given segments into a new segment.
+ *
+ * The sorted dictionaries of the segments are merged term by term, so only
+ * the posting lists of a single term are decoded at any time. Segments must
+ * have disjoint sets of documents.
+ *
+ * @param dirs Directories of the segments to merge.
+ * @param out_dir Directory of the merged segment.
+ *
+ * @throws std::runtime_error If a segment cannot be read or the merged segment
+ * cannot be written.
+ */
+void merge_segments(const std::vector<std::string>& dirs,
+                    const std::string& out_dir);
+
+/**
+ * @brief Merge the given segments and write the result with the given
+ * writer.
+ *
+ * This overload is used to split the merged postings into shards; see
+ * ir::ShardedIndexWriter. The writer is finished when the merge is done.
+ *
+ * @param dirs Directories of the segments to merge.
+ * @param writer Writer of the merged segments.
+ *
+ * @throws std::runtime_error If a segment cannot be read or the merged
+ * segments cannot be written.
+ */
+void merge_segments(const std::vector<std::string>& dirs,
+                    ShardedIndexWriter& writer);
+
+/**
+ * @brief Class to commit new segments to the index and merge small segments
+ * in a background thread.
+ *
+ * SegmentMerger owns the manifest while the indexer runs. The merge thread is
+ * started on construction and repeatedly merges ir::MERGE_FACTOR segments of
+ * the same shard and tier until no tier has enough segments. Meanwhile, new segments
+ * can be written and committed by the caller; a committed segment is picked
+ * up by the merge thread as soon as it completes a tier. Every change is
+ * written to the manifest before the replaced segments are deleted.
+ */
+class SegmentMerger {
+  public:
+    /**
+     * @brief Start merging the segments of the given manifest.
+     *
+     * @param manifest Manifest of the index as returned by read_manifest.
+     */
+    explicit SegmentMerger(Manifest manifest);
+
+    SegmentMerger(const SegmentMerger&) = delete;
+    SegmentMerger& operator=(const SegmentMerger&) = delete;
+
+    /**
+     * @brief Wait for the merges to finish.
+     */
+    ~SegmentMerger();
+
+    /**
+     * @brief Reserve the name of a new segment.
+     *
+     * @return Name of the segment directory under ir::INDEX_DIR.
+     */
+    std::string new_segment();
+
+    /**
+     * @brief Add written segments to the index.
+     *
+     * All the segments become visible to the searcher at the same time.
+     *
+     * @param segments Entries of the segments named by
+     * SegmentMerger::new_segment.
+     * @param files Data files whose documents are in the segments.
+     * @param common_terms Common terms the segments were built with.
+     *
+     * @throws std::runtime_error If the manifest cannot be written.
+     */
+    void commit(const std::vector<SegmentInfo>& segments,
+                const std::vector<std::string>& files,
+                const std::vector<std::string>& common_terms);
+
+    /**
+     * @brief Wait until no more segments can be merged and stop the merge
+     * thread.
+     *
+     * @throws std::runtime_error If a merge failed.
+     */
+    void finish();
+
+  private:
+    /**
+     * @brief Main loop of the merge thread.
+     */
+    void run();
+
+    /**
+     * @brief Return the indices of the segments to merge next; empty if no
+     * tier has enough segments.
+     */
+    std::vector<size_t> select_merge() const;
+
+    Manifest m_manifest;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_done = false;
+    std::string m_error;
+    std::thread m_thread;
+};
+} // namespace ir
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief Summary of the most frequent items of a stream in bounded memory
+ * using the Space-Saving algorithm.
+ *
+ * At most capacity items are monitored, each with a counter. An item that is
+ * already monitored increments its counter. A new item takes the place of the
+ * item with the smallest counter \f$c_{min}\f$ and starts counting from
+ * \f$c_{min} + 1\f$, so a counter overestimates the frequency of its item by
+ * at most \f$c_{min}\f$, which is at most \f$N / capacity\f$ after \f$N\f$
+ * updates. Hence, every item occurring more than \f$N / capacity\f$ times is
+ * monitored, and the most frequent items of a skewed stream such as the terms
+ * of a corpus are found with a small capacity.
+ *
+ * Counters are kept in the Stream-Summary structure of the original paper:
+ * a list of buckets in increasing order of count, each holding the list of
+ * the items with that count. Incrementing a counter by one moves its item to
+ * the next bucket and the smallest counter is in the first bucket, so an
+ * update takes constant time. Items are found with an open addressing hash
+ * table of counter indices. Replacing an item reuses its counter and the
+ * buffer of its string, so updates don't allocate memory once the summary
+ * is full.
+ */
+class SpaceSaving {
+  public:
+    /**
+     * @brief Construct an empty summary monitoring at most the given number
+     * of items.
+     *
+     * @param capacity Maximum number of monitored items; 0 ignores all the
+     * items.
+     */
+    explicit SpaceSaving(size_t capacity = 0);
+
+    /**
+     * @brief Return the maximum number of monitored items.
+     */
+    size_t capacity() const { return m_capacity; }
+
+    /**
+     * @brief Count count more occurrences of the given item.
+     */
+    void add(std::string_view item, size_t count = 1);
+
+    /**
+     * @brief Add the counters of the given summary to this summary.
+     *
+     * The counters of other are added as weighted updates, so the merged
+     * summary keeps the error bound of a summary of both streams.
+     */
+    void merge(const SpaceSaving& other);
+
+    /**
+     * @brief Return at most k monitored items with the largest counters and
+     * their counters in decreasing order of counter.
+     */
+    std::vector<std::pair<std::string, size_t>> top(size_t k) const;
+
+  private:
+    /**
+     * @brief Index standing for no item or bucket.
+     */
+    static constexpr uint32_t None = std::numeric_limits<uint32_t>::max();
+
+    /**
+     * @brief Counter of a monitored item in the list of counters of its
+     * bucket.
+     */
+    struct Counter {
+        std::string item;
+        uint64_t hash;
+        uint32_t bucket;
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    /**
+     * @brief Bucket of the counters with the same count in the list of
+     * buckets.
+     */
+    struct Bucket {
+        size_t count;
+        uint32_t first;
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    /**
+     * @brief Return the slot of the hash table holding the counter of the
+     * given item, or the free slot where it would be inserted.
+     */
+    size_t find_slot(std::string_view item, uint64_t hash) const;
+
+    /**
+     * @brief Remove the counter in the given slot from the hash table.
+     */
+    void erase_slot(size_t slot);
+
+    /**
+     * @brief Add the given counter to the bucket with the given count, which
+     * is created if it doesn't exist.
+     *
+     * @param index Index of a counter that is in no bucket.
+     * @param count Count of the counter.
+     * @param after Bucket whose count is less than count, or None; the
+     * bucket with count is searched from the next bucket.
+     */
+    void link(uint32_t index, size_t count, uint32_t after);
+
+    /**
+     * @brief Remove the given counter from its bucket, and the bucket from
+     * the list of buckets if it becomes empty.
+     *
+     * @return The bucket of the counter if it is still in the list;
+     * otherwise, the bucket preceding it or None.
+     */
+    uint32_t unlink(uint32_t index);
+
+    size_t m_capacity;
+    std::vector<Counter> m_counters;
+    std::vector<Bucket> m_buckets;
+    // indices of the buckets that are not in the list
+    std::vector<uint32_t> m_free_buckets;
+    // bucket with the smallest count
+    uint32_t m_first_bucket = None;
+    // index of the counter in each slot; None if the slot is free
+    std::vector<uint32_t> m_slots;
+};
+} // namespace ir
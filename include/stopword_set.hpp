@@ -0,0 +1,74 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief Immutable set of words with constant time lookups.
+ *
+ * The words are placed into a hash table by a perfect hash function: a seed of
+ * ir::hash_bytes is searched for so that no two words share a slot. A lookup
+ * hashes the word once and compares it against the single word in its slot,
+ * without allocating any memory. Since the set never changes after
+ * construction, it can be shared by any number of threads.
+ */
+class StopwordSet {
+  public:
+    /**
+     * @brief Default constructor that constructs an empty set.
+     */
+    StopwordSet() = default;
+
+    /**
+     * @brief Construct a set of the given words.
+     *
+     * @param words Words of the set. Duplicates are ignored.
+     */
+    explicit StopwordSet(std::vector<std::string> words);
+
+    /**
+     * @brief Return the number of words in the set.
+     */
+    size_t size() const { return m_words.size(); }
+
+    /**
+     * @brief Return true if the given word is in the set.
+     */
+    bool contains(std::string_view word) const;
+
+  private:
+    /**
+     * @brief Try to place every word into a distinct slot of a table of the
+     * given size using the given seed.
+     *
+     * @return true if no two words share a slot.
+     */
+    bool place_words(size_t slot_count, uint64_t seed);
+
+    std::vector<std::string> m_words;
+    // 1 + index of the word in each slot; 0 if the slot is free
+    std::vector<uint32_t> m_slots;
+    uint64_t m_seed = 0;
+};
+} // namespace ir
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace ir {
+
+/**
+ * @brief Return the position of the first tag opening character '<' in the
+ * given text at or after pos using the implementation for ir::simd_level.
+ *
+ * The markup of Reuters sgm files is the only place a raw '<' occurs since
+ * the text itself escapes it as "&lt;", so jumping from one '<' to the next
+ * visits every tag of a document while skipping its text in bulk.
+ *
+ * @param text Text to scan.
+ * @param pos Position to start scanning from.
+ *
+ * @return Position of the first '<' at or after pos;
+ * std::string_view::npos if there is no such character.
+ */
+size_t find_tag_open(std::string_view text, size_t pos = 0);
+
+/**
+ * @brief Portable implementation of ir::find_tag_open.
+ */
+size_t find_tag_open_scalar(std::string_view text, size_t pos = 0);
+
+/**
+ * @brief SSE2 implementation of ir::find_tag_open comparing 16 characters at
+ * a time. Must only be called if ir::simd_level is at least
+ * SimdLevel::SSE41.
+ */
+size_t find_tag_open_sse2(std::string_view text, size_t pos = 0);
+
+/**
+ * @brief AVX2 implementation of ir::find_tag_open comparing 32 characters at
+ * a time. Must only be called if ir::simd_level is SimdLevel::AVX2.
+ */
+size_t find_tag_open_avx2(std::string_view text, size_t pos = 0);
+
+/**
+ * @brief Return true if the given tag occurs in text at position pos.
+ */
+inline bool tag_at(std::string_view text, size_t pos, std::string_view tag) {
+    return text.compare(pos, tag.size(), tag) == 0;
+}
+
+/**
+ * @brief Return the position of the first occurrence of the given tag in text
+ * at or after pos.
+ *
+ * Only the '<' characters found by ir::find_tag_open are compared with the
+ * tag, so the tag must begin with '<'.
+ *
+ * @param text Text to search.
+ * @param tag Tag to find; must begin with '<'.
+ * @param pos Position to start searching from.
+ *
+ * @return Position of the beginning of the tag; std::string_view::npos if it
+ * doesn't occur.
+ */
+size_t find_tag(std::string_view text, std::string_view tag, size_t pos = 0);
+} // namespace ir
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include "mapped_file.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief Average number of terms per bucket of a TermHash.
+ *
+ * Larger buckets make the hash function smaller but slower to build.
+ */
+constexpr size_t TERM_HASH_BUCKET_SIZE = 4;
+
+/**
+ * @brief Slot of a TermHash holding the entry of a single term as it is
+ * stored in the term hash file.
+ */
+struct TermHashSlot {
+    /**
+     * @brief Byte offset of the posting list of the term in the index file.
+     */
+    uint64_t offset;
+    /**
+     * @brief Byte offset of the positions of the term in the position file.
+     */
+    uint64_t pos_offset;
+    /**
+     * @brief Size of the posting list of the term in bytes.
+     */
+    uint32_t length;
+    /**
+     * @brief Size of the positions of the term in bytes.
+     */
+    uint32_t pos_length;
+    /**
+     * @brief Number of documents the term occurs in.
+     */
+    uint32_t doc_count;
+    /**
+     * @brief Unique ID of the term.
+     */
+    uint32_t id;
+    /**
+     * @brief Byte offset of the term in the concatenation of all terms.
+     */
+    uint32_t term_offset;
+    /**
+     * @brief Length of the term in bytes.
+     */
+    uint32_t term_length;
+};
+
+/**
+ * @brief Build a minimal perfect hash function over the given terms and
+ * append it, together with the entry of each term, to out.
+ *
+ * The function is built using the hash and displace method. Every term is
+ * hashed once with ir::hash_bytes. The hash selects a bucket and two values
+ * \f$f\f$ and \f$g\f$, and the term is placed into slot
+ *
+ * \f$
+ * (f + d_0 g + d_1) \bmod n
+ * \f$
+ *
+ * where \f$n\f$ is the number of terms and \f$d = (d_0, d_1)\f$ is the
+ * displacement of the bucket. Buckets are processed from the largest to the
+ * smallest, and each bucket is given the first displacement that moves all of
+ * its terms into free slots. Hence, every slot holds exactly one term. The
+ * encoded hash has the following layout:
+ *
+ * <blockquote>
+ *
+ * <TERM_COUNT> <BUCKET_COUNT> <SEED> (8 bytes each)\n
+ * <DISPLACEMENT> <DISPLACEMENT> \f$\dots\f$ <DISPLACEMENT> (4 bytes each,
+ * padded to a multiple of 8 bytes)\n
+ * <SLOT> <SLOT> \f$\dots\f$ <SLOT> (ir::TermHashSlot each)\n
+ * <TERMS>\n
+ *
+ * </blockquote>
+ *
+ * where each <SLOT> holds the entry of the term placed in it and the location
+ * of the term in <TERMS>, which is the concatenation of all terms. The term is
+ * needed to verify that a looked up string is in the vocabulary at all.
+ *
+ * @param terms Terms to hash. Terms must be distinct.
+ * @param term_infos Entry of each term.
+ * @param out Byte vector the encoded hash is appended to.
+ */
+void encode_term_hash(const std::vector<std::string>& terms,
+                      const std::vector<TermInfo>& term_infos,
+                      std::vector<uint8_t>& out);
+
+/**
+ * @brief Read-only minimal perfect hash table from terms to their entries.
+ *
+ * TermHash memory maps the file written by ir::IndexWriter. A lookup
+ * hashes the term once, reads the displacement of its bucket and compares the
+ * term against the single candidate slot. Lookups don't allocate any memory.
+ */
+class TermHash {
+  public:
+    /**
+     * @brief Default constructor that constructs an empty table.
+     */
+    TermHash() = default;
+
+    /**
+     * @brief Map the term hash file at the given path.
+     *
+     * @param path Path of a file written by ir::IndexWriter.
+     *
+     * @throws std::runtime_error If the file cannot be mapped or is not a
+     * valid term hash file.
+     */
+    explicit TermHash(const std::string& path);
+
+    /**
+     * @brief Return the number of terms in the table.
+     */
+    size_t size() const { return m_term_count; }
+
+    /**
+     * @brief Find the entry of the given term.
+     *
+     * @param term Term to look up.
+     * @param info Entry of the term, if found. Otherwise, it is unchanged.
+     *
+     * @return true if the term exists in the table; false, otherwise.
+     */
+    bool find(const std::string& term, TermInfo& info) const;
+
+    /**
+     * @brief Return the entry of the given term.
+     *
+     * @throws std::out_of_range If the term doesn't exist in the table.
+     */
+    TermInfo at(const std::string& term) const;
+
+  private:
+    MappedFile m_file;
+    size_t m_term_count = 0;
+    size_t m_bucket_count = 0;
+    uint64_t m_seed = 0;
+    const uint32_t* m_displacements = nullptr;
+    const TermHashSlot* m_slots = nullptr;
+    const char* m_terms = nullptr;
+};
+} // namespace ir
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace ir {
+
+/**
+ * @brief ID standing for no term, e.g. the ID of a stopword.
+ */
+constexpr uint32_t NO_TERM_ID = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @brief Pool of the distinct terms of the documents being indexed assigning
+ * each term a dense integer ID.
+ *
+ * The tokenizers intern every normalized term as it is produced, so the
+ * indexer passes 32-bit IDs around instead of strings and every distinct
+ * term is stored exactly once. IDs are assigned in order of first occurrence
+ * starting from 0; they are only meaningful while indexing and are not the
+ * IDs written to the dictionary, which are assigned in sorted order of term.
+ *
+ * Terms are never removed, and views returned by TermPool::term stay valid
+ * as long as the pool exists. All the member functions can be called from
+ * several threads at the same time.
+ */
+class TermPool {
+  public:
+    /**
+     * @brief Return the ID of the given term, adding it to the pool if it is
+     * not in the pool yet.
+     */
+    uint32_t intern(std::string_view term);
+
+    /**
+     * @brief Return the term with the given ID, which must have been returned
+     * by TermPool::intern.
+     */
+    std::string_view term(uint32_t id) const {
+        std::shared_lock<std::shared_timed_mutex> lock(m_mutex);
+        return m_terms[id];
+    }
+
+    /**
+     * @brief Return the number of terms in the pool.
+     */
+    size_t size() const {
+        std::shared_lock<std::shared_timed_mutex> lock(m_mutex);
+        return m_terms.size();
+    }
+
+  private:
+    mutable std::shared_timed_mutex m_mutex;
+    // term of each ID; elements of a deque never move as it grows, so the
+    // views into them stay valid
+    std::deque<std::string> m_terms;
+    std::unordered_map<std::string_view, uint32_t> m_ids;
+};
+} // namespace ir
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief Fixed size pool of threads running submitted tasks with work
+ * stealing.
+ *
+ * Each worker thread has its own deque of tasks. Tasks submitted by a worker
+ * are pushed to the back of its own deque and run in LIFO order, so a task
+ * spawning subtasks keeps its data hot in the cache and the subtasks are run
+ * before older work. Tasks submitted from other threads are dealt to the
+ * deques in round robin order. A worker whose deque is empty steals the
+ * oldest task from the front of another deque, so the load is balanced even
+ * if the tasks have very different sizes.
+ *
+ * Threads are started on construction and joined on destruction after all
+ * the submitted tasks are run.
+ */
+class ThreadPool {
+  public:
+    /**
+     * @brief Start the given number of worker threads.
+     *
+     * @param thread_count Number of threads; at least 1.
+     */
+    explicit ThreadPool(size_t thread_count);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Run the remaining tasks and join the worker threads.
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief Return the number of worker threads.
+     */
+    size_t size() const { return m_threads.size(); }
+
+    /**
+     * @brief Return the index of the calling worker thread in
+     * [0, ThreadPool::size()); ThreadPool::size() if the caller is not a
+     * worker of this pool.
+     *
+     * The index can be used to give each worker its own copy of some state
+     * that is merged after all the tasks are run.
+     */
+    size_t worker_index() const;
+
+    /**
+     * @brief Schedule the given callable to run on one of the worker threads.
+     *
+     * @param task Callable taking no arguments.
+     *
+     * @return Future holding the result of task or the exception it threw.
+     * A task must not wait for the future of a task it submitted, which may
+     * be queued behind it on the same thread.
+     */
+    template <typename Task>
+    std::future<std::result_of_t<Task()>> submit(Task task) {
+        // std::function must be copyable; the packaged task is not
+        auto packaged =
+            std::make_shared<std::packaged_task<std::result_of_t<Task()>()>>(
+                std::move(task));
+        auto future = packaged->get_future();
+        push([packaged]() { (*packaged)(); });
+        return future;
+    }
+
+  private:
+    /**
+     * @brief Deque of the tasks of a worker thread.
+     */
+    struct TaskDeque {
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+    };
+
+    /**
+     * @brief Push the given task to the deque of the calling worker or, if
+     * called from another thread, to the next deque in round robin order.
+     */
+    void push(std::function<void()> task);
+
+    /**
+     * @brief Take a task from the back of the deque of the given worker or
+     * steal one from the front of another deque.
+     *
+     * @return false if all the deques are empty.
+     */
+    bool pop(size_t index, std::function<void()>& task);
+
+    /**
+     * @brief Main loop of the worker thread with the given index.
+     */
+    void run(size_t index);
+
+    std::vector<std::unique_ptr<TaskDeque>> m_deques;
+    std::vector<std::thread> m_threads;
+    // number of pushed tasks that no worker has claimed yet
+    size_t m_pending = 0;
+    size_t m_next_deque = 0;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_stop = false;
+};
+} // namespace ir
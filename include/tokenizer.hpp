@@ -17,12 +17,74 @@
 #pragma once
 
 #include "defs.hpp"
+#include "hyper_log_log.hpp"
+#include "normalization_cache.hpp"
+#include "porter_stemmer.hpp"
+#include "space_saving.hpp"
+#include "term_pool.hpp"
+#include <array>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 
 namespace ir {
 
+/**
+ * @brief How a Tokenizer gathers the term statistics of Tokenizer::Stats.
+ */
+enum class StatsMode {
+    /**
+     * @brief Count every distinct term exactly; memory grows with the
+     * vocabulary of the corpus.
+     */
+    Exact,
+    /**
+     * @brief Find the most frequent terms with an ir::SpaceSaving summary
+     * and estimate the number of distinct terms with an ir::HyperLogLog
+     * sketch in memory independent of the corpus.
+     */
+    Approximate,
+    /**
+     * @brief Don't gather term statistics; only tokens are counted.
+     */
+    Off
+};
+
+/**
+ * @brief Default number of terms monitored by the ir::SpaceSaving summaries
+ * of StatsMode::Approximate.
+ */
+constexpr size_t DEFAULT_TOP_TERM_CAPACITY = 1024;
+
+/**
+ * @brief Default precision of the ir::HyperLogLog sketches of
+ * StatsMode::Approximate, giving about 0.8% relative error.
+ */
+constexpr unsigned DEFAULT_TERM_COUNT_PRECISION = 14;
+
+/**
+ * @brief Options of the term statistics gathered by a Tokenizer.
+ */
+struct StatsOptions {
+    /**
+     * @brief How the term statistics are gathered.
+     */
+    StatsMode mode = StatsMode::Exact;
+    /**
+     * @brief Number of terms monitored to find the most frequent terms in
+     * StatsMode::Approximate. Terms occurring more than 1/capacity of the
+     * time are always found.
+     */
+    size_t top_term_capacity = DEFAULT_TOP_TERM_CAPACITY;
+    /**
+     * @brief Precision of the distinct term counts in
+     * StatsMode::Approximate; see ir::HyperLogLog.
+     */
+    unsigned term_count_precision = DEFAULT_TERM_COUNT_PRECISION;
+};
+
 /**
  * @brief Class to handle tokenization and normalization operations and keep
  * statistics about these operations.
@@ -71,8 +133,39 @@ class Tokenizer {
          * corpus after normalization operations.
          */
         std::array<std::string, TopTermCount> top_normalized_terms;
+        /**
+         * @brief How the term statistics were gathered. Term counts are
+         * estimates in StatsMode::Approximate and 0 in StatsMode::Off.
+         */
+        StatsMode mode;
+        /**
+         * @brief Number of tokens whose normalized term was found in the
+         * normalization cache.
+         */
+        size_t cache_hits;
+        /**
+         * @brief Number of tokens that were normalized because they were not
+         * in the normalization cache; 0 if the cache is disabled.
+         */
+        size_t cache_misses;
     };
 
+    /**
+     * @brief Construct a Tokenizer with a normalization cache of the given
+     * capacity.
+     *
+     * @param cache_capacity Maximum number of tokens whose normalized terms
+     * are cached; see ir::NormalizationCache. 0 disables the cache.
+     * @param stats_options How the term statistics are gathered.
+     * @param term_pool Pool the normalized terms are interned into; see
+     * Tokenizer::get_doc_term_ids. nullptr if the terms are not interned.
+     * The pool must outlive the tokenizer.
+     */
+    explicit Tokenizer(
+        size_t cache_capacity = DEFAULT_NORMALIZATION_CACHE_SIZE,
+        const StatsOptions& stats_options = StatsOptions(),
+        TermPool* term_pool = nullptr);
+
     /**
      * @brief Split the given string with respect to whitespace characters and
      * return the resulting tokens and their positions in the document as a
@@ -112,6 +205,56 @@ class Tokenizer {
     std::vector<std::pair<std::string, size_t>>
     get_doc_terms(const raw_doc& doc);
 
+    /**
+     * @brief Tokenize and normalize a given raw document into the given
+     * vector of terms.
+     *
+     * The strings already in terms are overwritten rather than destroyed, so
+     * a vector reused for many documents rarely allocates.
+     *
+     * @param doc Raw document.
+     * @param terms Vector replaced by the normalized terms of doc and their
+     * positions.
+     */
+    void get_doc_terms(std::string_view doc,
+                       std::vector<std::pair<std::string, size_t>>& terms);
+
+    /**
+     * @brief Tokenize and normalize a given raw document into the given
+     * vector of term IDs.
+     *
+     * Every normalized term is interned into the ir::TermPool of the
+     * tokenizer, which must have been given on construction. The ID of a
+     * token is cached together with its normalized term, so the pool is
+     * only searched for tokens that are not in the normalization cache.
+     *
+     * @param doc Raw document.
+     * @param terms Vector replaced by the IDs of the normalized terms of doc
+     * and their positions.
+     */
+    void get_doc_term_ids(std::string_view doc,
+                          std::vector<std::pair<uint32_t, size_t>>& terms);
+
+    /**
+     * @brief Tokenize and normalize a given raw document in a single pass
+     * and call the given function with each term and its position.
+     *
+     * Tokens are split by whitespace and normalized one at a time in buffers
+     * owned by the tokenizer as defined in ir::normalize; no vector of
+     * tokens is built. Stopwords are skipped but still take up a position,
+     * so positions are the indices of the tokens in the document.
+     *
+     * @param doc Raw document.
+     * @param callback Function called with each normalized term, its ID in
+     * the ir::TermPool of the tokenizer and its position in order of
+     * position. The term is only valid during the call. The ID is
+     * ir::NO_TERM_ID if the tokenizer has no term pool.
+     */
+    void for_each_term(
+        std::string_view doc,
+        const std::function<void(std::string_view, uint32_t, size_t)>&
+            callback);
+
     /**
      * @brief Return the normalized version a given token.
      *
@@ -127,10 +270,15 @@ class Tokenizer {
      * 3. Stopword removal
      *   * If the given token is a stopword, an empty string is returned.
      * 4. Stemming
-     *   * The resulting token is stemmed using the Porter Stemmer.
+     *   * The resulting token is stemmed in place using the ir::PorterStemmer
+     * of the tokenizer. Hence, a Tokenizer must not be used by several
+     * threads at the same time; use one Tokenizer per thread instead.
      *
      * @param token Token to normalize.
      *
+     * Normalized terms of the tokens seen so far are looked up in the
+     * normalization cache of the tokenizer before going through these steps.
+     *
      * @return Normalized version of the token. IF the given token is a
      * stopword, an empty string is returned.
      */
@@ -155,14 +303,33 @@ class Tokenizer {
      * defined in ir::STOPWORD_PATH.
      *
      * For efficiency purposes, the file is read only once when the function
-     * is called for the first time, and the stopword list is sorted. Then,
-     * stopword check is done using binary search.
+     * is called for the first time into an immutable ir::StopwordSet, which
+     * is shared by all the tokenizers. Then, stopword check is a single hash
+     * table probe. The function can be called from several threads.
      *
      * @param word Word to check if it is a stopword.
      *
      * @return true if word is in stopword list; false, otherwise.
      */
-    bool is_stopword(const std::string& word);
+    bool is_stopword(std::string_view word);
+
+    /**
+     * @brief Add the statistics gathered by the given tokenizer to the
+     * statistics of this tokenizer.
+     *
+     * Documents can be tokenized in parallel with one Tokenizer per thread;
+     * merging the tokenizers gives the same statistics as tokenizing all the
+     * documents with a single Tokenizer.
+     *
+     * @param other Tokenizer that processed documents disjoint from the ones
+     * processed by this tokenizer with the same statistics options.
+     */
+    void merge_stats(const Tokenizer& other);
+
+    /**
+     * @brief Return the options of the term statistics of the tokenizer.
+     */
+    const StatsOptions& stats_options() const { return m_stats_options; }
 
     /**
      * @brief Return the statistics gathered until this point.
@@ -175,8 +342,70 @@ class Tokenizer {
     Stats stats();
 
   private:
-    std::unordered_map<std::string, size_t> unnormalized_terms;
-    std::unordered_map<std::string, size_t> normalized_terms;
+    /**
+     * @brief Return the normalized version of the given token; see
+     * Tokenizer::normalize.
+     *
+     * The returned term is a view of a buffer of the tokenizer or of its
+     * cache and is valid until the next token is normalized.
+     *
+     * @param token Token to normalize.
+     * @param term_id Output ID of the term in the term pool; ir::NO_TERM_ID
+     * if the token is a stopword or the tokenizer has no term pool.
+     */
+    std::string_view normalize_view(std::string_view token,
+                                    uint32_t& term_id);
+
+    /**
+     * @brief Normalize the given token into m_term without looking it up in
+     * the cache; see Tokenizer::normalize.
+     */
+    void normalize_uncached(std::string_view token);
+
+    /**
+     * @brief Term statistics of either the tokens or the normalized terms.
+     */
+    struct TermStats {
+        /**
+         * @brief Count of each term in StatsMode::Exact.
+         */
+        std::unordered_map<std::string, size_t> counts;
+        /**
+         * @brief Most frequent terms in StatsMode::Approximate.
+         */
+        SpaceSaving top_terms;
+        /**
+         * @brief Number of distinct terms in StatsMode::Approximate.
+         */
+        HyperLogLog term_count;
+    };
+
+    /**
+     * @brief Count an occurrence of the given term in the given statistics
+     * as specified by the statistics mode.
+     *
+     * In StatsMode::Exact, the term is copied into m_key, which keeps its
+     * capacity, so that no string is allocated for terms that are already
+     * counted.
+     */
+    void count_term(TermStats& term_stats, std::string_view term);
+
+    /**
+     * @brief Fill the given count and top terms from the given statistics.
+     */
+    void
+    summarize(const TermStats& term_stats, size_t& term_count,
+              std::array<std::string, Stats::TopTermCount>& top_terms) const;
+
+    StatsOptions m_stats_options;
+    TermPool* m_term_pool;
+    TermStats unnormalized_terms;
+    TermStats normalized_terms;
+    // reusable buffers of the term being normalized and of map keys
+    std::string m_term;
+    std::string m_key;
     Stats m_stats;
+    PorterStemmer m_stemmer;
+    NormalizationCache m_cache;
 };
 } // namespace ir
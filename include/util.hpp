@@ -25,8 +25,9 @@ namespace ir {
  * @brief Split the given input string using one of the delimeters and return
  * a vector of tokens.
  *
- * This function is a wrapper around well-known C strtok function to tokenize
- * a string using a list of delimiters.
+ * This function is a wrapper around the reentrant version of the well-known
+ * C strtok function to tokenize a string using a list of delimiters. It can
+ * be called from several threads.
  *
  * @param str String to tokenize. Characters that are one of the given
  * delimiters will be replaced by the NULL character.
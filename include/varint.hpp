@@ -0,0 +1,92 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ir {
+
+/**
+ * @brief Encode the given integer using variable-byte encoding and write the
+ * resulting bytes to out.
+ *
+ * The integer is split into groups of 7 bits starting from the least
+ * significant group. Each group is written as a single byte whose most
+ * significant bit is set if more groups follow. Hence, integers less than 128
+ * occupy a single byte, integers less than 16384 occupy two bytes, and so on.
+ *
+ * @tparam OutputIterator Iterator type of the output byte sequence.
+ * @param value Integer to encode.
+ * @param out Beginning of the output sequence.
+ *
+ * @return Iterator pointing to the end of the output sequence.
+ */
+template <typename OutputIterator>
+OutputIterator encode_varint(uint64_t value, OutputIterator out) {
+    while (value >= 0x80) {
+        *out = static_cast<uint8_t>(value | 0x80);
+        ++out;
+        value >>= 7;
+    }
+    *out = static_cast<uint8_t>(value);
+    ++out;
+    return out;
+}
+
+/**
+ * @brief Decode a single variable-byte encoded integer starting at ptr and
+ * advance ptr past it.
+ *
+ * @param ptr Pointer to the first byte of an integer encoded by
+ * ir::encode_varint. After the call, ptr points to the byte following the
+ * decoded integer.
+ *
+ * @return Decoded integer.
+ */
+inline uint64_t decode_varint(const uint8_t*& ptr) {
+    uint64_t value = *ptr & 0x7F;
+    unsigned shift = 7;
+    while (*ptr++ & 0x80) {
+        value |= static_cast<uint64_t>(*ptr & 0x7F) << shift;
+        shift += 7;
+    }
+    return value;
+}
+
+/**
+ * @brief Skip the given number of variable-byte encoded integers starting at
+ * ptr without decoding them.
+ *
+ * Since the last byte of each encoded integer is the only one whose most
+ * significant bit is clear, skipping amounts to counting such bytes.
+ *
+ * @param ptr Pointer to the first byte of an integer encoded by
+ * ir::encode_varint.
+ * @param count Number of integers to skip.
+ *
+ * @return Pointer to the byte following the last skipped integer.
+ */
+inline const uint8_t* skip_varints(const uint8_t* ptr, size_t count) {
+    while (count != 0) {
+        if ((*ptr++ & 0x80) == 0) {
+            --count;
+        }
+    }
+    return ptr;
+}
+} // namespace ir
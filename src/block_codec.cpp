@@ -0,0 +1,324 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "block_codec.hpp"
+#include <array>
+#include <cstring>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define IR_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Number of integers in each of the four lanes of a packed block.
+ */
+static constexpr unsigned LANE_SIZE = ir::BLOCK_SIZE / 4;
+
+/**
+ * @brief Return a mask whose least significant bits bits are set.
+ */
+static constexpr uint32_t low_mask(unsigned bits) {
+    return bits == 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+}
+
+/**
+ * @brief Signature of an unpack routine specialized for a single bit width.
+ */
+using unpack_fn = void (*)(const uint8_t*, uint32_t*);
+
+/**
+ * @brief Unpack a block packed with B bits one integer at a time.
+ *
+ * This is the fallback used when the CPU doesn't support any of the SIMD
+ * implementations. Since B is a compile time constant, the compiler unrolls
+ * the loop and resolves the word and shift of each integer statically.
+ */
+template <unsigned B>
+static void unpack_scalar_fixed(const uint8_t* in, uint32_t* out) {
+    std::array<uint32_t, 4 * B> words;
+    std::memcpy(words.data(), in, ir::packed_block_size(B));
+
+#pragma GCC unroll 128
+    for (size_t i = 0; i < ir::BLOCK_SIZE; ++i) {
+        const size_t lane = i % 4;
+        const size_t bit = (i / 4) * B;
+        const size_t word = bit / 32;
+        const size_t shift = bit % 32;
+
+        uint32_t v = words[4 * word + lane] >> shift;
+        if (shift + B > 32) {
+            // shift is nonzero here; the mask only keeps the compiler from
+            // warning in the instantiations where this branch is dead
+            v |= words[4 * (word + 1) + lane] << ((32 - shift) & 31);
+        }
+        out[i] = v & low_mask(B);
+    }
+}
+
+template <size_t... B>
+static constexpr std::array<unpack_fn, sizeof...(B)>
+make_scalar_table(std::index_sequence<B...>) {
+    return {{&unpack_scalar_fixed<B>...}};
+}
+
+/**
+ * @brief Scalar routines indexed by bit width. Width 0 is handled separately.
+ */
+static constexpr auto scalar_table =
+    make_scalar_table(std::make_index_sequence<33>());
+
+#ifdef IR_X86_SIMD
+/**
+ * @brief Unpack a block packed with B bits using 128-bit SSE registers.
+ *
+ * Each iteration produces one integer of each lane, i.e. four consecutive
+ * integers of the block. Since B is a compile time constant, the loop is fully
+ * unrolled and all the shift amounts are immediates.
+ */
+template <unsigned B>
+__attribute__((target("sse4.1"))) static void
+unpack_sse41_fixed(const uint8_t* in, uint32_t* out) {
+    const auto* in_vec = reinterpret_cast<const __m128i*>(in);
+    auto* out_vec = reinterpret_cast<__m128i*>(out);
+    const __m128i mask = _mm_set1_epi32(static_cast<int>(low_mask(B)));
+
+#pragma GCC unroll 32
+    for (unsigned j = 0; j < LANE_SIZE; ++j) {
+        const unsigned bit = j * B;
+        const unsigned word = bit / 32;
+        const unsigned shift = bit % 32;
+
+        __m128i v = _mm_srli_epi32(_mm_loadu_si128(in_vec + word), shift);
+        // the integer continues in the next word of the lane
+        if (shift + B > 32) {
+            __m128i next = _mm_loadu_si128(in_vec + word + 1);
+            v = _mm_or_si128(v, _mm_slli_epi32(next, 32 - shift));
+        }
+        _mm_storeu_si128(out_vec + j, _mm_and_si128(v, mask));
+    }
+}
+
+/**
+ * @brief Load the lane words of the rows lo and hi of a packed block into the
+ * lower and upper halves of a 256-bit register.
+ *
+ * When the rows are equal or adjacent, which is known at compile time in the
+ * unrolled loops, a single broadcast or unaligned load is used.
+ */
+__attribute__((target("avx2"))) static inline __m256i
+load_rows(const __m128i* in_vec, unsigned lo, unsigned hi) {
+    if (hi == lo + 1) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in_vec + lo));
+    } else if (hi == lo) {
+        return _mm256_broadcastsi128_si256(_mm_loadu_si128(in_vec + lo));
+    }
+    return _mm256_set_m128i(_mm_loadu_si128(in_vec + hi),
+                            _mm_loadu_si128(in_vec + lo));
+}
+
+/**
+ * @brief Unpack a block packed with B bits using 256-bit AVX2 registers.
+ *
+ * Each iteration produces two integers of each lane by placing two rows of
+ * lane words into the two halves of a 256-bit register and shifting them by
+ * different amounts with the variable shift instructions of AVX2. Variable
+ * shifts by 32 or more produce zero, which handles the halves whose integer
+ * doesn't continue in the next word.
+ */
+template <unsigned B>
+__attribute__((target("avx2"))) static void
+unpack_avx2_fixed(const uint8_t* in, uint32_t* out) {
+    const auto* in_vec = reinterpret_cast<const __m128i*>(in);
+    auto* out_vec = reinterpret_cast<__m256i*>(out);
+    const __m256i mask = _mm256_set1_epi32(static_cast<int>(low_mask(B)));
+
+#pragma GCC unroll 16
+    for (unsigned j = 0; j < LANE_SIZE; j += 2) {
+        const unsigned bit_lo = j * B;
+        const unsigned bit_hi = (j + 1) * B;
+        const unsigned word_lo = bit_lo / 32;
+        const unsigned word_hi = bit_hi / 32;
+        const unsigned shift_lo = bit_lo % 32;
+        const unsigned shift_hi = bit_hi % 32;
+        const bool spill_lo = shift_lo + B > 32;
+        const bool spill_hi = shift_hi + B > 32;
+
+        __m256i words = load_rows(in_vec, word_lo, word_hi);
+        __m256i shifts = _mm256_set_epi32(shift_hi, shift_hi, shift_hi,
+                                          shift_hi, shift_lo, shift_lo,
+                                          shift_lo, shift_lo);
+        __m256i v = _mm256_srlv_epi32(words, shifts);
+
+        if (spill_lo || spill_hi) {
+            // never read past the block for a half that doesn't spill
+            const unsigned next_lo = spill_lo ? word_lo + 1 : word_lo;
+            const unsigned next_hi = spill_hi ? word_hi + 1 : word_hi;
+            const int left_lo = spill_lo ? 32 - shift_lo : 32;
+            const int left_hi = spill_hi ? 32 - shift_hi : 32;
+
+            __m256i next = load_rows(in_vec, next_lo, next_hi);
+            __m256i lefts = _mm256_set_epi32(left_hi, left_hi, left_hi, left_hi,
+                                             left_lo, left_lo, left_lo, left_lo);
+            v = _mm256_or_si256(v, _mm256_sllv_epi32(next, lefts));
+        }
+        _mm256_storeu_si256(out_vec + j / 2, _mm256_and_si256(v, mask));
+    }
+}
+
+template <size_t... B>
+static constexpr std::array<unpack_fn, sizeof...(B)>
+make_sse41_table(std::index_sequence<B...>) {
+    return {{&unpack_sse41_fixed<B>...}};
+}
+
+template <size_t... B>
+static constexpr std::array<unpack_fn, sizeof...(B)>
+make_avx2_table(std::index_sequence<B...>) {
+    return {{&unpack_avx2_fixed<B>...}};
+}
+
+/**
+ * @brief SSE4.1 routines indexed by bit width. Width 0 is handled separately.
+ */
+static constexpr auto sse41_table =
+    make_sse41_table(std::make_index_sequence<33>());
+
+/**
+ * @brief AVX2 routines indexed by bit width. Width 0 is handled separately.
+ */
+static constexpr auto avx2_table =
+    make_avx2_table(std::make_index_sequence<33>());
+
+__attribute__((target("sse4.1"))) static void
+prefix_sum_sse41(uint32_t* values, uint32_t base) {
+    auto* vec = reinterpret_cast<__m128i*>(values);
+    __m128i carry = _mm_set1_epi32(static_cast<int>(base));
+
+    for (size_t i = 0; i < ir::BLOCK_SIZE / 4; ++i) {
+        // in-register prefix sum of four integers in two shift-add steps
+        __m128i x = _mm_loadu_si128(vec + i);
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, carry);
+        _mm_storeu_si128(vec + i, x);
+        // broadcast the last sum to use as the carry of the next four
+        carry = _mm_shuffle_epi32(x, 0xFF);
+    }
+}
+#endif
+
+static ir::SimdLevel detect_simd_level() {
+#ifdef IR_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return ir::SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return ir::SimdLevel::SSE41;
+    }
+#endif
+    return ir::SimdLevel::Scalar;
+}
+
+ir::SimdLevel ir::simd_level() {
+    static const SimdLevel level = detect_simd_level();
+    return level;
+}
+
+unsigned ir::max_bits(const uint32_t* in, size_t count) {
+    uint32_t acc = 0;
+    for (size_t i = 0; i < count; ++i) {
+        acc |= in[i];
+    }
+    return acc == 0 ? 0 : 32 - static_cast<unsigned>(__builtin_clz(acc));
+}
+
+void ir::pack_block(const uint32_t* in, unsigned bits, uint8_t* out) {
+    std::array<uint32_t, BLOCK_SIZE> words{};
+
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        const size_t lane = i % 4;
+        const size_t bit = (i / 4) * bits;
+        const size_t word = bit / 32;
+        const size_t shift = bit % 32;
+
+        words[4 * word + lane] |= in[i] << shift;
+        if (shift + bits > 32) {
+            words[4 * (word + 1) + lane] |= in[i] >> (32 - shift);
+        }
+    }
+    std::memcpy(out, words.data(), packed_block_size(bits));
+}
+
+void ir::unpack_block_scalar(const uint8_t* in, unsigned bits, uint32_t* out) {
+    if (bits == 0) {
+        std::memset(out, 0, BLOCK_SIZE * sizeof(uint32_t));
+    } else {
+        scalar_table[bits](in, out);
+    }
+}
+
+void ir::unpack_block_sse41(const uint8_t* in, unsigned bits, uint32_t* out) {
+#ifdef IR_X86_SIMD
+    if (bits == 0) {
+        std::memset(out, 0, BLOCK_SIZE * sizeof(uint32_t));
+    } else {
+        sse41_table[bits](in, out);
+    }
+#else
+    unpack_block_scalar(in, bits, out);
+#endif
+}
+
+void ir::unpack_block_avx2(const uint8_t* in, unsigned bits, uint32_t* out) {
+#ifdef IR_X86_SIMD
+    if (bits == 0) {
+        std::memset(out, 0, BLOCK_SIZE * sizeof(uint32_t));
+    } else {
+        avx2_table[bits](in, out);
+    }
+#else
+    unpack_block_scalar(in, bits, out);
+#endif
+}
+
+void ir::unpack_block(const uint8_t* in, unsigned bits, uint32_t* out) {
+    switch (simd_level()) {
+    case SimdLevel::AVX2:
+        unpack_block_avx2(in, bits, out);
+        break;
+    case SimdLevel::SSE41:
+        unpack_block_sse41(in, bits, out);
+        break;
+    default:
+        unpack_block_scalar(in, bits, out);
+    }
+}
+
+void ir::prefix_sum_block(uint32_t* values, uint32_t base) {
+#ifdef IR_X86_SIMD
+    if (simd_level() != SimdLevel::Scalar) {
+        prefix_sum_sse41(values, base);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        base += values[i];
+        values[i] = base;
+    }
+}
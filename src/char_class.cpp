@@ -0,0 +1,89 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "char_class.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+
+/**
+ * @brief Return a mask whose i^th bit is set if the i^th of the given 16
+ * characters is a delimiter.
+ *
+ * The delimiters are space and the range [\\t, \\r]; bytes of non-ASCII
+ * characters compare as negative, so they never fall in the range.
+ */
+static unsigned delimiter_mask(const char* str) {
+    const __m128i chars =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+    const __m128i space = _mm_cmpeq_epi8(chars, _mm_set1_epi8(' '));
+    const __m128i control =
+        _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('\t' - 1)),
+                      _mm_cmplt_epi8(chars, _mm_set1_epi8('\r' + 1)));
+    return static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_or_si128(space, control)));
+}
+#endif
+
+void ir::to_lower(char* str, size_t size) {
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i before_a = _mm_set1_epi8('A' - 1);
+    const __m128i after_z = _mm_set1_epi8('Z' + 1);
+    const __m128i case_bit = _mm_set1_epi8('a' - 'A');
+    for (; i + 16 <= size; i += 16) {
+        auto* vec = reinterpret_cast<__m128i*>(str + i);
+        const __m128i chars = _mm_loadu_si128(vec);
+        const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chars, before_a),
+                                            _mm_cmplt_epi8(chars, after_z));
+        _mm_storeu_si128(
+            vec, _mm_or_si128(chars, _mm_and_si128(upper, case_bit)));
+    }
+#endif
+    for (; i < size; ++i) {
+        str[i] = to_lower(str[i]);
+    }
+}
+
+size_t ir::find_delimiter(std::string_view text, size_t pos) {
+#ifdef __SSE2__
+    for (; pos + 16 <= text.size(); pos += 16) {
+        const unsigned mask = delimiter_mask(text.data() + pos);
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+#endif
+    while (pos < text.size() && !is_delimiter(text[pos])) {
+        ++pos;
+    }
+    return pos;
+}
+
+size_t ir::skip_delimiters(std::string_view text, size_t pos) {
+#ifdef __SSE2__
+    for (; pos + 16 <= text.size(); pos += 16) {
+        const unsigned mask = ~delimiter_mask(text.data() + pos) & 0xFFFFu;
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+#endif
+    while (pos < text.size() && is_delimiter(text[pos])) {
+        ++pos;
+    }
+    return pos;
+}
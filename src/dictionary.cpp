@@ -0,0 +1,212 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dictionary.hpp"
+#include "file_manager.hpp"
+#include "varint.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+/**
+ * @brief Append the given integer to out as 8 little endian bytes.
+ */
+static void append_u64(uint64_t value, std::vector<uint8_t>& out) {
+    for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void ir::encode_dictionary(const std::vector<std::string>& terms,
+                           const std::vector<TermInfo>& term_infos,
+                           std::vector<uint8_t>& out) {
+    assert(terms.size() == term_infos.size());
+    const size_t block_count =
+        (terms.size() + DICT_BLOCK_SIZE - 1) / DICT_BLOCK_SIZE;
+
+    std::vector<uint8_t> blocks;
+    std::vector<uint64_t> block_offsets;
+    auto blocks_it = std::back_inserter(blocks);
+    for (size_t i = 0; i < terms.size(); ++i) {
+        const auto& term = terms[i];
+        const auto& info = term_infos[i];
+        assert(info.id == i);
+
+        size_t prefix_len = 0;
+        if (i % DICT_BLOCK_SIZE == 0) {
+            // first term of a block is stored in full
+            block_offsets.push_back(blocks.size());
+            encode_varint(info.offset, blocks_it);
+            encode_varint(info.pos_offset, blocks_it);
+        } else {
+            const auto& prev = terms[i - 1];
+            assert(prev < term);
+            assert(term_infos[i - 1].offset + term_infos[i - 1].length ==
+                   info.offset);
+            assert(term_infos[i - 1].pos_offset +
+                       term_infos[i - 1].pos_length ==
+                   info.pos_offset);
+            const size_t max_len = std::min(prev.size(), term.size());
+            while (prefix_len < max_len && prev[prefix_len] == term[prefix_len]) {
+                ++prefix_len;
+            }
+        }
+
+        encode_varint(prefix_len, blocks_it);
+        encode_varint(term.size() - prefix_len, blocks_it);
+        blocks.insert(blocks.end(), term.begin() + prefix_len, term.end());
+        encode_varint(info.doc_count, blocks_it);
+        encode_varint(info.length, blocks_it);
+        encode_varint(info.pos_length, blocks_it);
+    }
+
+    append_u64(terms.size(), out);
+    append_u64(block_count, out);
+    for (uint64_t offset : block_offsets) {
+        append_u64(offset, out);
+    }
+    out.insert(out.end(), blocks.begin(), blocks.end());
+}
+
+ir::Dictionary::Dictionary(const std::string& path)
+    : m_file(path, MappedFile::AccessPattern::Random) {
+    const size_t header_size = DICT_MAGIC.size() + 2 * sizeof(uint64_t);
+    if (m_file.size() < header_size ||
+        std::memcmp(m_file.data(), DICT_MAGIC.data(), DICT_MAGIC.size()) != 0) {
+        throw std::runtime_error(path + " is not a valid dictionary file!");
+    }
+
+    const char* header = m_file.data() + DICT_MAGIC.size();
+    uint64_t term_count, block_count;
+    std::memcpy(&term_count, header, sizeof(uint64_t));
+    std::memcpy(&block_count, header + sizeof(uint64_t), sizeof(uint64_t));
+    if (block_count != (term_count + DICT_BLOCK_SIZE - 1) / DICT_BLOCK_SIZE ||
+        m_file.size() < header_size + block_count * sizeof(uint64_t)) {
+        throw std::runtime_error(path + " is not a valid dictionary file!");
+    }
+
+    m_term_count = term_count;
+    m_block_count = block_count;
+    // the magic is a multiple of 8 bytes long, so the table is aligned
+    m_block_offsets =
+        reinterpret_cast<const uint64_t*>(m_file.data() + header_size);
+    m_blocks = reinterpret_cast<const uint8_t*>(m_file.data() + header_size +
+                                                block_count * sizeof(uint64_t));
+}
+
+size_t ir::Dictionary::find_block(const std::string& term) const {
+    // binary search for the first block whose first term is greater than term
+    size_t low = 0;
+    size_t high = m_block_count;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+
+        // skip the posting offsets and the zero prefix length
+        const uint8_t* ptr = skip_varints(block(mid), 3);
+        const size_t len = decode_varint(ptr);
+        const auto* first = reinterpret_cast<const char*>(ptr);
+
+        if (term.compare(0, std::string::npos, first, len) < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low == 0 ? 0 : low - 1;
+}
+
+bool ir::Dictionary::find(const std::string& term, TermInfo& info) const {
+    const size_t block_index = find_block(term);
+    const size_t block_end = (block_index + 1) * DICT_BLOCK_SIZE;
+
+    // terms are sorted; stop at the first term that is not less than term
+    for (DictionaryCursor cursor(*this, block_index);
+         cursor.valid() && cursor.info().id < block_end; cursor.next()) {
+        const int cmp = cursor.term().compare(term);
+        if (cmp == 0) {
+            info = cursor.info();
+            return true;
+        } else if (cmp > 0) {
+            break;
+        }
+    }
+    return false;
+}
+
+ir::TermInfo ir::Dictionary::at(const std::string& term) const {
+    TermInfo info;
+    if (!find(term, info)) {
+        throw std::out_of_range(term + " does not exist in the dictionary");
+    }
+    return info;
+}
+
+ir::DictionaryCursor ir::Dictionary::begin() const {
+    return DictionaryCursor(*this, 0);
+}
+
+ir::DictionaryCursor ir::Dictionary::lower_bound(const std::string& term) const {
+    DictionaryCursor cursor(*this, find_block(term));
+    while (cursor.valid() && cursor.term() < term) {
+        cursor.next();
+    }
+    return cursor;
+}
+
+ir::DictionaryCursor::DictionaryCursor(const Dictionary& dict, size_t block)
+    : m_dict(&dict), m_ptr(nullptr),
+      m_info{dict.m_term_count, 0, 0, 0, 0, 0} {
+    if (block < dict.m_block_count) {
+        m_ptr = dict.block(block);
+        m_info.id = block * DICT_BLOCK_SIZE;
+        m_info.offset = decode_varint(m_ptr);
+        m_info.pos_offset = decode_varint(m_ptr);
+        decode_entry();
+    }
+}
+
+void ir::DictionaryCursor::next() {
+    if (++m_info.id >= m_dict->m_term_count) {
+        return;
+    }
+
+    if (m_info.id % DICT_BLOCK_SIZE == 0) {
+        // the first term of each block stores its posting offsets
+        m_info.offset = decode_varint(m_ptr);
+        m_info.pos_offset = decode_varint(m_ptr);
+    } else {
+        // posting lists of consecutive terms are adjacent
+        m_info.offset += m_info.length;
+        m_info.pos_offset += m_info.pos_length;
+    }
+    decode_entry();
+}
+
+void ir::DictionaryCursor::decode_entry() {
+    const size_t prefix_len = decode_varint(m_ptr);
+    const size_t suffix_len = decode_varint(m_ptr);
+
+    // the shared prefix is already in m_term
+    m_term.resize(prefix_len);
+    m_term.append(reinterpret_cast<const char*>(m_ptr), suffix_len);
+    m_ptr += suffix_len;
+
+    m_info.doc_count = decode_varint(m_ptr);
+    m_info.length = decode_varint(m_ptr);
+    m_info.pos_length = decode_varint(m_ptr);
+}
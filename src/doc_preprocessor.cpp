@@ -15,44 +15,76 @@
  */
 
 #include "doc_preprocessor.hpp"
+#include <cstring>
+#include <utility>
 
 /**
- * @brief Return a static map containing special HTML sequences and their ASCII
- * equivalents.
- *
- * @return std::unordered_map from HTML sequences to chars.
+ * @brief Special HTML sequences and their ASCII equivalents.
  */
-static std::unordered_map<std::string, char> html_special_str_to_ascii() {
-    return std::unordered_map<std::string, char>({
-        {"&#1;", ' '},
-        {"&#2;", ' '},
-        {"&#3;", ' '},
-        {"&#5;", 5},
-        {"&#22;", ' '},
-        {"&#27;", ' '},
-        {"&#30;", 30},
-        {"&#31;", 31},
-        {"&#127;", ' '},
-        {"&amp;", '&'},
-        {"&lt;", '<'},
-        {"&gt;", '>'},
-    });
+static constexpr std::pair<std::string_view, char> HTML_SPECIAL_CHARS[] = {
+    {"&#1;", ' '},   {"&#2;", ' '},   {"&#3;", ' '},  {"&#5;", 5},
+    {"&#22;", ' '},  {"&#27;", ' '},  {"&#30;", 30},  {"&#31;", 31},
+    {"&#127;", ' '}, {"&amp;", '&'},  {"&lt;", '<'},  {"&gt;", '>'},
 };
 
-void ir::convert_html_special_chars(raw_doc& doc) {
-    size_t index;
-    for (const auto& sym_pair : html_special_str_to_ascii()) {
-        const auto& html_sym = sym_pair.first;
-        char ascii_char = sym_pair.second;
+/**
+ * @brief Return the entry of HTML_SPECIAL_CHARS for the sequence at the
+ * beginning of the given text; nullptr if the text doesn't begin with any of
+ * the sequences.
+ */
+static const std::pair<std::string_view, char>*
+match_html_special_char(std::string_view text) {
+    for (const auto& sym_pair : HTML_SPECIAL_CHARS) {
+        if (text.compare(0, sym_pair.first.size(), sym_pair.first) == 0) {
+            return &sym_pair;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Copy the given text to out converting the special HTML sequences on
+ * the way; see ir::convert_html_special_chars.
+ *
+ * out may point to the text itself since nothing is written past the end of
+ * the sequence being read.
+ */
+static void decode_html_special_chars(std::string_view text, char* out) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        // copy the characters up to the next sequence in bulk
+        const auto* amp = static_cast<const char*>(
+            std::memchr(text.data() + pos, '&', text.size() - pos));
+        const size_t amp_pos =
+            amp ? static_cast<size_t>(amp - text.data()) : text.size();
+        if (out + pos != text.data() + pos) {
+            std::memmove(out + pos, text.data() + pos, amp_pos - pos);
+        }
+        pos = amp_pos;
+        if (pos == text.size()) {
+            break;
+        }
 
-        // find all occurrences of html_sym
-        while ((index = doc.find(html_sym)) != std::string::npos) {
-            // replace the beginning with space
-            for (size_t offset = 0; offset < html_sym.size() - 1; ++offset) {
-                doc[index + offset] = ' ';
-            }
-            // replace last char with ASCII equivalent
-            doc[index + html_sym.size() - 1] = ascii_char;
+        const auto* sym_pair = match_html_special_char(text.substr(pos));
+        if (sym_pair == nullptr) {
+            out[pos++] = '&';
+            continue;
         }
+        // replace the beginning with space and the last char with the ASCII
+        // equivalent
+        const size_t len = sym_pair->first.size();
+        std::memset(out + pos, ' ', len - 1);
+        out[pos + len - 1] = sym_pair->second;
+        pos += len;
     }
 }
+
+void ir::convert_html_special_chars(raw_doc& doc) {
+    decode_html_special_chars(doc, &doc[0]);
+}
+
+void ir::convert_html_special_chars(std::string_view text, raw_doc& out) {
+    const size_t offset = out.size();
+    out.resize(offset + text.size());
+    decode_html_special_chars(text, &out[offset]);
+}
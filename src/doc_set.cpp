@@ -0,0 +1,244 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "doc_set.hpp"
+#include <array>
+#include <cassert>
+#include <cstring>
+
+/**
+ * @brief Number of bytes of an entry of the chunk table of a DocSet.
+ */
+constexpr size_t CHUNK_ENTRY_SIZE = 3 * sizeof(uint32_t);
+
+/**
+ * @brief Number of 8 byte words of a bitmap container.
+ */
+constexpr size_t BITMAP_WORDS = (size_t(1) << ir::DOC_SET_CHUNK_BITS) / 64;
+
+/**
+ * @brief Append the given integer to out as little endian bytes.
+ */
+template <typename UInt>
+static void append_le(UInt value, std::vector<uint8_t>& out) {
+    for (size_t i = 0; i < sizeof(UInt); ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+/**
+ * @brief Read a little endian integer from ptr.
+ */
+template <typename UInt> static UInt load_le(const uint8_t* ptr) {
+    UInt value;
+    std::memcpy(&value, ptr, sizeof(UInt));
+    return value;
+}
+
+bool ir::is_dense(const std::vector<size_t>& doc_ids) {
+    size_t chunk_begin = 0;
+    for (size_t i = 1; i <= doc_ids.size(); ++i) {
+        if (i == doc_ids.size() ||
+            (doc_ids[i] >> DOC_SET_CHUNK_BITS) !=
+                (doc_ids[chunk_begin] >> DOC_SET_CHUNK_BITS)) {
+            if (i - chunk_begin > ARRAY_CONTAINER_MAX) {
+                return true;
+            }
+            chunk_begin = i;
+        }
+    }
+    return false;
+}
+
+void ir::encode_doc_set(const std::vector<size_t>& doc_ids,
+                        std::vector<uint8_t>& out) {
+    std::vector<uint8_t> entries;
+    std::vector<uint8_t> containers;
+    std::array<uint64_t, BITMAP_WORDS> words;
+
+    uint32_t chunk_count = 0;
+    size_t chunk_begin = 0;
+    while (chunk_begin < doc_ids.size()) {
+        const size_t key = doc_ids[chunk_begin] >> DOC_SET_CHUNK_BITS;
+        size_t chunk_end = chunk_begin;
+        while (chunk_end < doc_ids.size() &&
+               (doc_ids[chunk_end] >> DOC_SET_CHUNK_BITS) == key) {
+            ++chunk_end;
+        }
+
+        const size_t cardinality = chunk_end - chunk_begin;
+        append_le(static_cast<uint32_t>(key), entries);
+        append_le(static_cast<uint32_t>(cardinality), entries);
+        append_le(static_cast<uint32_t>(containers.size()), entries);
+
+        const size_t low_mask = (size_t(1) << DOC_SET_CHUNK_BITS) - 1;
+        if (cardinality <= ARRAY_CONTAINER_MAX) {
+            for (size_t i = chunk_begin; i < chunk_end; ++i) {
+                append_le(static_cast<uint16_t>(doc_ids[i] & low_mask),
+                          containers);
+            }
+        } else {
+            words.fill(0);
+            for (size_t i = chunk_begin; i < chunk_end; ++i) {
+                const size_t low = doc_ids[i] & low_mask;
+                words[low / 64] |= uint64_t(1) << (low % 64);
+            }
+            for (uint64_t word : words) {
+                append_le(word, containers);
+            }
+        }
+
+        ++chunk_count;
+        chunk_begin = chunk_end;
+    }
+
+    append_le(chunk_count, out);
+    out.insert(out.end(), entries.begin(), entries.end());
+    out.insert(out.end(), containers.begin(), containers.end());
+}
+
+ir::DocSet::DocSet(const uint8_t* begin)
+    : m_entries(begin + sizeof(uint32_t)),
+      m_chunk_count(load_le<uint32_t>(begin)) {
+    m_containers = m_entries + m_chunk_count * CHUNK_ENTRY_SIZE;
+}
+
+uint32_t ir::DocSet::key(size_t chunk) const {
+    return load_le<uint32_t>(m_entries + chunk * CHUNK_ENTRY_SIZE);
+}
+
+uint32_t ir::DocSet::cardinality(size_t chunk) const {
+    return load_le<uint32_t>(m_entries + chunk * CHUNK_ENTRY_SIZE +
+                             sizeof(uint32_t));
+}
+
+const uint8_t* ir::DocSet::container(size_t chunk) const {
+    return m_containers +
+           load_le<uint32_t>(m_entries + chunk * CHUNK_ENTRY_SIZE +
+                             2 * sizeof(uint32_t));
+}
+
+size_t ir::DocSet::find_chunk(uint32_t target) const {
+    size_t low = 0;
+    size_t high = m_chunk_count;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (key(mid) < target) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return (low < m_chunk_count && key(low) == target) ? low : m_chunk_count;
+}
+
+bool ir::DocSet::chunk_contains(size_t chunk, uint32_t low_bits) const {
+    const uint8_t* data = container(chunk);
+    const uint32_t count = cardinality(chunk);
+    if (count > ARRAY_CONTAINER_MAX) {
+        const uint64_t word = load_le<uint64_t>(data + low_bits / 64 * 8);
+        return (word >> (low_bits % 64)) & 1;
+    }
+
+    // binary search the sorted array
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (load_le<uint16_t>(data + 2 * mid) < low_bits) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low < count && load_le<uint16_t>(data + 2 * low) == low_bits;
+}
+
+bool ir::DocSet::contains(size_t doc_id) const {
+    const size_t chunk =
+        find_chunk(static_cast<uint32_t>(doc_id >> DOC_SET_CHUNK_BITS));
+    if (chunk == m_chunk_count) {
+        return false;
+    }
+    const uint32_t low_mask = (uint32_t(1) << DOC_SET_CHUNK_BITS) - 1;
+    return chunk_contains(chunk, static_cast<uint32_t>(doc_id) & low_mask);
+}
+
+std::vector<size_t> ir::DocSet::intersect(const std::vector<DocSet>& sets) {
+    assert(!sets.empty());
+    std::vector<size_t> result;
+    std::vector<size_t> chunks(sets.size());
+    std::array<uint64_t, BITMAP_WORDS> words;
+
+    const auto& first = sets[0];
+    for (size_t chunk = 0; chunk < first.m_chunk_count; ++chunk) {
+        // the chunk must exist in every set; the one with the fewest
+        // documents drives the intersection
+        const uint32_t key = first.key(chunk);
+        chunks[0] = chunk;
+        size_t driver = 0;
+        bool found = true;
+        for (size_t i = 1; i < sets.size() && found; ++i) {
+            chunks[i] = sets[i].find_chunk(key);
+            found = chunks[i] != sets[i].m_chunk_count;
+            if (found && sets[i].cardinality(chunks[i]) <
+                             sets[driver].cardinality(chunks[driver])) {
+                driver = i;
+            }
+        }
+        if (!found) {
+            continue;
+        }
+
+        const size_t base = size_t(key) << DOC_SET_CHUNK_BITS;
+        const uint32_t count = sets[driver].cardinality(chunks[driver]);
+        if (count <= ARRAY_CONTAINER_MAX) {
+            // probe each document of the array in the other chunks
+            const uint8_t* array = sets[driver].container(chunks[driver]);
+            for (uint32_t j = 0; j < count; ++j) {
+                const uint16_t low = load_le<uint16_t>(array + 2 * j);
+                bool in_all = true;
+                for (size_t i = 0; i < sets.size() && in_all; ++i) {
+                    in_all =
+                        i == driver || sets[i].chunk_contains(chunks[i], low);
+                }
+                if (in_all) {
+                    result.push_back(base + low);
+                }
+            }
+            continue;
+        }
+
+        // every chunk is a bitmap; AND them 64 documents at a time
+        const uint8_t* bitmap = first.container(chunk);
+        for (size_t w = 0; w < BITMAP_WORDS; ++w) {
+            words[w] = load_le<uint64_t>(bitmap + 8 * w);
+        }
+        for (size_t i = 1; i < sets.size(); ++i) {
+            bitmap = sets[i].container(chunks[i]);
+            for (size_t w = 0; w < BITMAP_WORDS; ++w) {
+                words[w] &= load_le<uint64_t>(bitmap + 8 * w);
+            }
+        }
+        for (size_t w = 0; w < BITMAP_WORDS; ++w) {
+            for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+                result.push_back(base + w * 64 + __builtin_ctzll(word));
+            }
+        }
+    }
+
+    return result;
+}
@@ -15,12 +15,15 @@
  */
 
 #include <dirent.h>
+#include <unistd.h>
 
 #include "file_manager.hpp"
-#include "util.hpp"
+#include "index_writer.hpp"
 #include <algorithm>
-#include <cassert>
+#include <cstdio>
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
 
 std::vector<std::string> ir::get_data_file_list() {
     DIR* dirp = opendir(DATASET_DIR.c_str());
@@ -45,108 +48,120 @@ std::vector<std::string> ir::get_data_file_list() {
     return file_list;
 }
 
-void ir::write_dict_file(const pos_inv_index& inverted_index) {
-    size_t index = 0;
-    std::ofstream ofs(ir::DICT_PATH, std::ios_base::trunc);
-
-    // write each term and its corresponding ID on a separate line
-    for (const auto& pair : inverted_index) {
-        const auto& term = pair.first;
-        ofs << term << ' ' << index << '\n';
-        ++index;
+std::vector<std::string>
+ir::sorted_terms(const pos_inv_index& inverted_index) {
+    std::vector<std::string> terms;
+    terms.reserve(inverted_index.size());
+    for (const auto& term_pair : inverted_index) {
+        terms.push_back(term_pair.first);
     }
-    ofs << std::flush;
+    std::sort(terms.begin(), terms.end());
+    return terms;
 }
 
-void ir::write_index_file(const pos_inv_index& inverted_index) {
-    size_t index = 0;
-    std::ofstream ofs(INDEX_PATH, std::ios_base::trunc);
-
-    for (const auto& term_pair : inverted_index) {
-        const auto& doc_vec = term_pair.second;
+std::string ir::segment_dir(const std::string& name) {
+    return INDEX_DIR + '/' + name;
+}
 
-        ofs << index << '\n' << POS_LIST_BEG_TAG << '\n';
+ir::Manifest ir::read_manifest() {
+    Manifest manifest;
+    std::ifstream ifs(MANIFEST_PATH);
+    if (!ifs) {
+        // no index yet
+        return manifest;
+    }
 
-        // write position list of each doc that term appears in
-        for (const auto& doc_pair : doc_vec) {
-            size_t doc_id = doc_pair.first;
-            const auto& pos_vec = doc_pair.second;
-            ofs << '\t' << doc_id << " :";
-            for (size_t pos : pos_vec) {
-                ofs << ' ' << pos;
+    std::string line;
+    while (std::getline(ifs, line)) {
+        const size_t space = line.find(' ');
+        const std::string key = line.substr(0, space);
+        const std::string value =
+            space == std::string::npos ? "" : line.substr(space + 1);
+
+        std::istringstream iss(value);
+        if (key == "NEXT" && iss >> manifest.next_id) {
+            continue;
+        } else if (key == "FILE" && !value.empty()) {
+            manifest.files.push_back(value);
+            continue;
+        } else if (key == "COMMON" && !value.empty()) {
+            manifest.common_terms.push_back(value);
+            continue;
+        } else if (key == "SEGMENT") {
+            SegmentInfo segment;
+            if (iss >> segment.name >> segment.doc_count >> segment.shard) {
+                manifest.segments.push_back(segment);
+                continue;
             }
-            ofs << '\n';
         }
-        ofs << POS_LIST_END_TAG << '\n';
-        ++index;
+        throw std::runtime_error(MANIFEST_PATH + " is not a valid manifest!");
     }
-    ofs << std::flush;
+
+    return manifest;
 }
 
-ir::term_id_map ir::read_dict_file() {
-    term_id_map result;
-    std::string term;
-    size_t id;
+void ir::write_manifest(const Manifest& manifest) {
+    const std::string tmp_path = MANIFEST_PATH + ".tmp";
+    std::ofstream ofs(tmp_path, std::ios_base::trunc);
+    ofs << "NEXT " << manifest.next_id << '\n';
+    for (const auto& segment : manifest.segments) {
+        ofs << "SEGMENT " << segment.name << ' ' << segment.doc_count << ' '
+            << segment.shard << '\n';
+    }
+    for (const auto& file : manifest.files) {
+        ofs << "FILE " << file << '\n';
+    }
+    for (const auto& term : manifest.common_terms) {
+        ofs << "COMMON " << term << '\n';
+    }
+    ofs << std::flush;
+    ofs.close();
+
+    // rename is atomic, so the manifest is never seen half written
+    if (!ofs || std::rename(tmp_path.c_str(), MANIFEST_PATH.c_str()) != 0) {
+        throw std::runtime_error("Could not write " + MANIFEST_PATH);
+    }
+}
 
-    std::ifstream ifs(DICT_PATH);
-    if (!ifs) {
-        throw std::runtime_error(DICT_PATH + " does not exist in the current folder!");
+void ir::write_segment(const std::string& dir,
+                       const pos_inv_index& inverted_index) {
+    IndexWriter writer(dir);
+    for (const auto& term : sorted_terms(inverted_index)) {
+        writer.add(term, inverted_index.at(term));
     }
+    writer.finish();
+}
 
-    // read each line and construct the dictionary
-    while (ifs >> term >> id) {
-        result[term] = id;
+void ir::remove_segment(const std::string& dir) {
+    for (const auto& file :
+         {DICT_FILE, INDEX_FILE, POSITIONS_FILE, TERM_HASH_FILE}) {
+        unlink((dir + '/' + file).c_str());
     }
+    rmdir(dir.c_str());
+}
 
-    return result;
+ir::Dictionary ir::read_dict_file(const std::string& dir) {
+    return Dictionary(dir + '/' + DICT_FILE);
 }
 
-ir::id_pos_map ir::read_index_file() {
-    id_pos_map result;
-    size_t term_id, doc_id, pos;
-    std::string tag;
-    std::string pos_line;
+ir::TermHash ir::read_term_hash_file(const std::string& dir) {
+    return TermHash(dir + '/' + TERM_HASH_FILE);
+}
 
-    std::ifstream ifs(INDEX_PATH);
-    if (!ifs) {
-        throw std::runtime_error(INDEX_PATH + " does not exist in the current folder!");
-    }
+ir::IndexReader ir::read_index_file(const std::string& dir) {
+    return IndexReader(dir + '/' + INDEX_FILE, dir + '/' + POSITIONS_FILE);
+}
 
-    // start reading an entry by first reading the term ID
-    while (ifs >> term_id) {
-        // get rid of newline
-        ifs.ignore(1);
-
-        // read begin tag
-        std::getline(ifs, tag);
-        assert(tag == POS_LIST_BEG_TAG);
-
-        // while end tag is not reached, continue reading
-        std::getline(ifs, pos_line);
-        while (pos_line != POS_LIST_END_TAG) {
-            // document id on current line
-            auto first_space = pos_line.find(' ');
-            doc_id = std::stoul(pos_line.substr(1, first_space - 1));
-
-            // beginning index of the position list
-            size_t num_beg = first_space + 3;
-            // get the rest of the line
-            std::string pos_str = pos_line.substr(num_beg);
-            // split tokens by space
-            std::vector<std::string> pos_str_vec = split(pos_str, " ");
-
-            // transform string positions to int positions
-            std::vector<size_t> pos_vec(pos_str_vec.size());
-            std::transform(
-                pos_str_vec.begin(), pos_str_vec.end(), pos_vec.begin(),
-                [](const std::string& pos_str) { return std::stoul(pos_str); });
-
-            // Add <doc_id, pos_list> pair to document list of current term
-            result[term_id].emplace_back(doc_id, pos_vec);
-
-            std::getline(ifs, pos_line);
-        }
+std::vector<ir::IndexSegment> ir::read_index(const Manifest& manifest) {
+    if (manifest.next_id == 0) {
+        throw std::runtime_error(MANIFEST_PATH +
+                                 " does not exist! Run indexer first.");
     }
 
-    return result;
+    std::vector<IndexSegment> segments;
+    for (const auto& segment : manifest.segments) {
+        const std::string dir = segment_dir(segment.name);
+        segments.push_back({read_term_hash_file(dir), read_index_file(dir)});
+    }
+    return segments;
 }
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hyper_log_log.hpp"
+#include "hash.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+ir::HyperLogLog::HyperLogLog(unsigned precision)
+    : m_precision(precision == 0
+                      ? 0
+                      : std::min(std::max(precision, MinPrecision),
+                                 MaxPrecision)) {
+    if (m_precision != 0) {
+        m_registers.assign(size_t(1) << m_precision, 0);
+    }
+}
+
+void ir::HyperLogLog::add(std::string_view item) {
+    if (m_registers.empty()) {
+        return;
+    }
+
+    const uint64_t hash = hash_bytes(item.data(), item.size());
+    const size_t index = hash >> (64 - m_precision);
+    // the remaining bits always end with a set bit so that the rank is
+    // bounded even if they are all zero
+    const uint64_t rest =
+        (hash << m_precision) | (uint64_t(1) << (m_precision - 1));
+    const auto rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+    m_registers[index] = std::max(m_registers[index], rank);
+}
+
+void ir::HyperLogLog::merge(const HyperLogLog& other) {
+    assert(m_precision == other.m_precision);
+    for (size_t i = 0; i < m_registers.size(); ++i) {
+        m_registers[i] = std::max(m_registers[i], other.m_registers[i]);
+    }
+}
+
+double ir::HyperLogLog::estimate() const {
+    if (m_registers.empty()) {
+        return 0;
+    }
+
+    const double m = static_cast<double>(m_registers.size());
+    double sum = 0;
+    size_t zero_count = 0;
+    for (uint8_t reg : m_registers) {
+        sum += std::ldexp(1.0, -static_cast<int>(reg));
+        zero_count += reg == 0;
+    }
+
+    // bias correction constant of the original paper for m >= 128; smaller
+    // sketches use the constants for m = 16, 32 and 64
+    double alpha = 0.7213 / (1 + 1.079 / m);
+    if (m == 16) {
+        alpha = 0.673;
+    } else if (m == 32) {
+        alpha = 0.697;
+    } else if (m == 64) {
+        alpha = 0.709;
+    }
+    const double estimate = alpha * m * m / sum;
+
+    // linear counting is more accurate for small cardinalities
+    if (estimate <= 2.5 * m && zero_count != 0) {
+        return m * std::log(m / static_cast<double>(zero_count));
+    }
+    return estimate;
+}
@@ -0,0 +1,371 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "index_builder.hpp"
+#include "bigram.hpp"
+#include "dictionary.hpp"
+#include "file_manager.hpp"
+#include "hash.hpp"
+#include "index_writer.hpp"
+#include "posting_list.hpp"
+#include "segment.hpp"
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+
+/**
+ * @brief Approximate number of bytes used by a term in the in-memory block,
+ * i.e. the hash table node and the empty document vector. The characters of
+ * the term are stored once in the term pool.
+ */
+constexpr size_t TERM_OVERHEAD =
+    sizeof(ir::id_inv_index::value_type) + 2 * sizeof(void*);
+
+/**
+ * @brief Approximate number of bytes used by a document in the document
+ * vector of a term besides its positions.
+ */
+constexpr size_t DOC_OVERHEAD =
+    sizeof(ir::id_inv_index::mapped_type::value_type);
+
+/**
+ * @brief Return the key of the in-memory block of the bigram of the terms
+ * with the given IDs.
+ *
+ * The key of a term is its ID, which fits into 32 bits, so the key of a
+ * bigram holds the ID of its first term plus one in its upper 32 bits.
+ */
+static uint64_t bigram_key_of(uint32_t first, uint32_t second) {
+    return (static_cast<uint64_t>(first) + 1) << 32 | second;
+}
+
+/**
+ * @brief Return true if the given key of the in-memory block is the key of a
+ * bigram.
+ */
+static bool is_bigram_id_key(uint64_t key) { return (key >> 32) != 0; }
+
+/**
+ * @brief Return the partition of the in-memory block holding the given key.
+ */
+static size_t partition_of(uint64_t key) {
+    return ir::mix64(key) % ir::INVERSION_PARTITION_COUNT;
+}
+
+/**
+ * @brief Add an occurrence of the term with the given key in the given
+ * document to the given block.
+ *
+ * @return Approximate number of bytes added to the block.
+ */
+static size_t add_posting(ir::id_inv_index& block, size_t doc_id,
+                          uint64_t key, size_t pos) {
+    size_t memory_used = sizeof(size_t);
+    const auto inserted = block.emplace(key, ir::id_inv_index::mapped_type());
+    auto& doc_vec = inserted.first->second;
+    if (inserted.second) {
+        memory_used += TERM_OVERHEAD;
+    }
+
+    // the postings of a document are added to a partition at once, so only
+    // the last document of a term can be the current one
+    if (doc_vec.empty() || doc_vec.back().first != doc_id) {
+        doc_vec.emplace_back(doc_id, std::vector<size_t>());
+        memory_used += DOC_OVERHEAD;
+    }
+    doc_vec.back().second.push_back(pos);
+    return memory_used;
+}
+
+/**
+ * @brief Sort the document vectors of the given block by document ID.
+ */
+static void sort_block(ir::id_inv_index& block) {
+    // documents may be added in any order of ID
+    for (auto& pair : block) {
+        auto& doc_vec = pair.second;
+        std::sort(doc_vec.begin(), doc_vec.end(),
+                  [](const auto& left, const auto& right) {
+                      return left.first < right.first;
+                  });
+    }
+}
+
+ir::IndexBuilder::IndexBuilder(const std::string& dir, size_t memory_budget,
+                               const std::vector<std::string>& common_terms,
+                               TermPool& term_pool)
+    : m_dir(dir), m_memory_budget(memory_budget), m_memory_used(0),
+      m_common_terms(common_terms),
+      m_choose_common_terms(common_terms.empty()), m_term_pool(term_pool) {
+    for (size_t i = 0; i < INVERSION_PARTITION_COUNT; ++i) {
+        m_partitions.push_back(std::make_unique<Partition>());
+    }
+    intern_common_terms();
+}
+
+void ir::IndexBuilder::intern_common_terms() {
+    m_common_ids.clear();
+    for (const auto& term : m_common_terms) {
+        m_common_ids.push_back(m_term_pool.intern(term));
+    }
+    std::sort(m_common_ids.begin(), m_common_ids.end());
+}
+
+bool ir::IndexBuilder::is_common_id(uint32_t term_id) const {
+    return std::binary_search(m_common_ids.begin(), m_common_ids.end(),
+                              term_id);
+}
+
+std::string ir::IndexBuilder::key_string(uint64_t key) const {
+    if (!is_bigram_id_key(key)) {
+        return std::string(m_term_pool.term(static_cast<uint32_t>(key)));
+    }
+    const auto first = static_cast<uint32_t>((key >> 32) - 1);
+    const auto second = static_cast<uint32_t>(key);
+    std::string result(m_term_pool.term(first));
+    result += ' ';
+    result += m_term_pool.term(second);
+    return result;
+}
+
+void ir::IndexBuilder::add_document(
+    size_t doc_id, const std::vector<std::pair<uint32_t, size_t>>& terms) {
+    // group the postings by partition so that each partition is locked once
+    std::vector<std::vector<std::pair<uint64_t, size_t>>> parts(
+        m_partitions.size());
+    for (const auto& term_pos : terms) {
+        parts[partition_of(term_pos.first)].emplace_back(term_pos.first,
+                                                         term_pos.second);
+    }
+
+    // a bigram occurs at the position of its first term
+    for (size_t i = 1; i < terms.size(); ++i) {
+        const auto& first = terms[i - 1];
+        const auto& second = terms[i];
+        if (second.second == first.second + 1 && is_common_id(first.first) &&
+            is_common_id(second.first)) {
+            const uint64_t key = bigram_key_of(first.first, second.first);
+            parts[partition_of(key)].emplace_back(key, first.second);
+        }
+    }
+    {
+        std::shared_lock<std::shared_timed_mutex> block_lock(m_block_mutex);
+        size_t memory_used = 0;
+        for (size_t i = 0; i < parts.size(); ++i) {
+            if (parts[i].empty()) {
+                continue;
+            }
+            auto& partition = *m_partitions[i];
+            std::lock_guard<std::mutex> lock(partition.mutex);
+            for (const auto& key_pos : parts[i]) {
+                memory_used += add_posting(partition.block, doc_id,
+                                           key_pos.first, key_pos.second);
+            }
+        }
+        m_memory_used += memory_used;
+
+        std::lock_guard<std::mutex> lock(m_doc_mutex);
+        m_doc_ids.push_back(doc_id);
+    }
+
+    if (m_memory_used > m_memory_budget) {
+        std::lock_guard<std::shared_timed_mutex> block_lock(m_block_mutex);
+        // another thread may have spilled the block in the meantime
+        if (m_memory_used > m_memory_budget) {
+            spill();
+        }
+    }
+}
+
+void ir::IndexBuilder::write_block(ShardedIndexWriter& writer) {
+    // partitions hold disjoint sets of terms, so the entries of all the
+    // partitions are sorted together by the terms they stand for
+    using entry = std::pair<std::string, id_inv_index::mapped_type*>;
+    std::vector<entry> entries;
+    for (auto& partition : m_partitions) {
+        sort_block(partition->block);
+        for (auto& pair : partition->block) {
+            entries.emplace_back(key_string(pair.first), &pair.second);
+        }
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const entry& left, const entry& right) {
+                  return left.first < right.first;
+              });
+
+    for (const auto& pair : entries) {
+        writer.add(pair.first, *pair.second);
+    }
+    writer.finish();
+
+    // release the memory of the block
+    for (auto& partition : m_partitions) {
+        id_inv_index().swap(partition->block);
+    }
+    m_memory_used = 0;
+}
+
+void ir::IndexBuilder::spill() {
+    m_runs.push_back(m_dir + ".run" + std::to_string(m_runs.size()));
+    ShardedIndexWriter writer({m_runs.back()}, {});
+    write_block(writer);
+}
+
+void ir::IndexBuilder::choose_common_terms() {
+    // runs hold disjoint documents, so the document frequency of a term is
+    // the sum of its frequencies in the block and the runs. No bigrams have
+    // been indexed yet
+    std::unordered_map<std::string, size_t> doc_freqs;
+    for (const auto& partition : m_partitions) {
+        for (const auto& pair : partition->block) {
+            doc_freqs[key_string(pair.first)] += pair.second.size();
+        }
+    }
+    for (const auto& run : m_runs) {
+        const auto dict = read_dict_file(run);
+        for (auto cursor = dict.begin(); cursor.valid(); cursor.next()) {
+            doc_freqs[cursor.term()] += cursor.info().doc_count;
+        }
+    }
+
+    // ties are broken by term so that the choice is deterministic
+    std::vector<std::pair<std::string, size_t>> terms(doc_freqs.begin(),
+                                                      doc_freqs.end());
+    const size_t count = std::min(COMMON_TERM_COUNT, terms.size());
+    std::partial_sort(terms.begin(), terms.begin() + count, terms.end(),
+                      [](const auto& left, const auto& right) {
+                          return left.second != right.second
+                                     ? left.second > right.second
+                                     : left.first < right.first;
+                      });
+
+    m_common_terms.clear();
+    for (size_t i = 0; i < count; ++i) {
+        m_common_terms.push_back(terms[i].first);
+    }
+    std::sort(m_common_terms.begin(), m_common_terms.end());
+    intern_common_terms();
+}
+
+void ir::IndexBuilder::add_common_bigrams() {
+    // the block and the runs hold disjoint documents, so the bigrams of each
+    // are found separately
+    std::vector<occurrence> occurrences;
+    for (const uint32_t term_id : m_common_ids) {
+        const auto& block = m_partitions[partition_of(term_id)]->block;
+        const auto it = block.find(term_id);
+        if (it == block.end()) {
+            continue;
+        }
+        for (const auto& doc_pos : it->second) {
+            for (const size_t pos : doc_pos.second) {
+                occurrences.emplace_back(doc_pos.first, pos, term_id);
+            }
+        }
+    }
+    add_bigrams(occurrences);
+
+    // runs spilled below only hold documents whose bigrams are added, so
+    // they are not visited
+    const std::vector<std::string> runs = m_runs;
+    for (const auto& run : runs) {
+        const auto dict = read_dict_file(run);
+        const auto index = read_index_file(run);
+        occurrences.clear();
+        for (const auto& term : m_common_terms) {
+            TermInfo info;
+            if (!dict.find(term, info)) {
+                continue;
+            }
+            const uint32_t term_id = m_term_pool.intern(term);
+            for (PostingCursor postings(index.postings(info));
+                 postings.valid(); postings.next()) {
+                for (const uint32_t pos : postings.positions()) {
+                    occurrences.emplace_back(postings.doc_id(), pos, term_id);
+                }
+            }
+        }
+        add_bigrams(occurrences);
+
+        if (m_memory_used > m_memory_budget) {
+            spill();
+        }
+    }
+}
+
+void ir::IndexBuilder::add_bigrams(std::vector<occurrence>& occurrences) {
+    // adjacent occurrences in the same document form a bigram, which occurs
+    // at the position of its first term
+    std::sort(occurrences.begin(), occurrences.end());
+    size_t memory_used = 0;
+    for (size_t i = 1; i < occurrences.size(); ++i) {
+        const auto& first = occurrences[i - 1];
+        const auto& second = occurrences[i];
+        if (std::get<0>(first) != std::get<0>(second) ||
+            std::get<1>(second) != std::get<1>(first) + 1) {
+            continue;
+        }
+        const uint64_t key =
+            bigram_key_of(std::get<2>(first), std::get<2>(second));
+        memory_used += add_posting(m_partitions[partition_of(key)]->block,
+                                   std::get<0>(first), key,
+                                   std::get<1>(first));
+    }
+    m_memory_used += memory_used;
+}
+
+std::vector<size_t>
+ir::IndexBuilder::finish(const std::vector<std::string>& dirs) {
+    assert(!dirs.empty() && dirs.size() <= m_doc_ids.size());
+
+    // split the sorted document IDs into ranges of equal size
+    std::sort(m_doc_ids.begin(), m_doc_ids.end());
+    std::vector<size_t> shard_begins;
+    std::vector<size_t> doc_counts;
+    size_t prev_rank = 0;
+    for (size_t i = 1; i <= dirs.size(); ++i) {
+        const size_t rank = i * m_doc_ids.size() / dirs.size();
+        if (i < dirs.size()) {
+            shard_begins.push_back(m_doc_ids[rank]);
+        }
+        doc_counts.push_back(rank - prev_rank);
+        prev_rank = rank;
+    }
+
+    // once the common terms are chosen, their bigrams are found from their
+    // positions in the block and the runs
+    if (m_choose_common_terms) {
+        choose_common_terms();
+        add_common_bigrams();
+    }
+
+    ShardedIndexWriter writer(dirs, shard_begins);
+    if (m_runs.empty()) {
+        // everything fits into memory; no need to merge
+        write_block(writer);
+        return doc_counts;
+    }
+
+    if (m_memory_used > 0) {
+        spill();
+    }
+    merge_segments(m_runs, writer);
+    for (const auto& run : m_runs) {
+        remove_segment(run);
+    }
+    m_runs.clear();
+    return doc_counts;
+}
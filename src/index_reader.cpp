@@ -0,0 +1,52 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "index_reader.hpp"
+#include "file_manager.hpp"
+#include <cstring>
+#include <stdexcept>
+
+ir::IndexReader::IndexReader(const std::string& path,
+                             const std::string& pos_path)
+    : m_file(path, MappedFile::AccessPattern::Random),
+      m_pos_file(pos_path, MappedFile::AccessPattern::Random) {
+    if (m_file.size() < INDEX_MAGIC.size() ||
+        std::memcmp(m_file.data(), INDEX_MAGIC.data(), INDEX_MAGIC.size()) !=
+            0) {
+        throw std::runtime_error(path + " is not a valid index file!");
+    }
+    if (m_pos_file.size() < POSITIONS_MAGIC.size() ||
+        std::memcmp(m_pos_file.data(), POSITIONS_MAGIC.data(),
+                    POSITIONS_MAGIC.size()) != 0) {
+        throw std::runtime_error(pos_path + " is not a valid position file!");
+    }
+}
+
+ir::PostingList ir::IndexReader::postings(const TermInfo& info) const {
+    if (info.offset < INDEX_MAGIC.size() ||
+        info.offset + info.length > m_file.size() ||
+        info.pos_offset < POSITIONS_MAGIC.size() ||
+        info.pos_offset + info.pos_length > m_pos_file.size()) {
+        throw std::out_of_range("Posting list of term " +
+                                std::to_string(info.id) +
+                                " is outside the index files");
+    }
+
+    const auto* data = reinterpret_cast<const uint8_t*>(m_file.data());
+    const auto* pos_data = reinterpret_cast<const uint8_t*>(m_pos_file.data());
+    return PostingList(data + info.offset, data + info.offset + info.length,
+                       pos_data + info.pos_offset);
+}
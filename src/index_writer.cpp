@@ -0,0 +1,143 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "index_writer.hpp"
+#include "dictionary.hpp"
+#include "file_manager.hpp"
+#include "posting_list.hpp"
+#include "term_hash.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <stdexcept>
+#include <sys/stat.h>
+
+/**
+ * @brief Write the given magic bytes followed by the given bytes to a new file
+ * at path.
+ *
+ * @throws std::runtime_error If the file cannot be written.
+ */
+static void write_binary_file(const std::string& path, const std::string& magic,
+                              const std::vector<uint8_t>& bytes) {
+    std::ofstream ofs(path, std::ios_base::trunc | std::ios_base::binary);
+    ofs.write(magic.data(), magic.size());
+    ofs.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    ofs << std::flush;
+    if (!ofs) {
+        throw std::runtime_error("Could not write " + path);
+    }
+}
+
+ir::IndexWriter::IndexWriter(const std::string& dir)
+    : m_dir(dir), m_offset(INDEX_MAGIC.size()),
+      m_pos_offset(POSITIONS_MAGIC.size()) {
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Could not create " + dir);
+    }
+
+    const auto mode = std::ios_base::trunc | std::ios_base::binary;
+    m_index.open(dir + '/' + INDEX_FILE, mode);
+    m_positions.open(dir + '/' + POSITIONS_FILE, mode);
+    if (!m_index || !m_positions) {
+        throw std::runtime_error("Could not create the index files in " + dir);
+    }
+    m_index.write(INDEX_MAGIC.data(), INDEX_MAGIC.size());
+    m_positions.write(POSITIONS_MAGIC.data(), POSITIONS_MAGIC.size());
+}
+
+void ir::IndexWriter::add(
+    const std::string& term,
+    const std::vector<std::pair<size_t, std::vector<size_t>>>& doc_vec) {
+    assert(m_terms.empty() || m_terms.back() < term);
+
+    m_doc_buffer.clear();
+    m_pos_buffer.clear();
+    encode_posting_list(doc_vec, m_doc_buffer, m_pos_buffer);
+    m_index.write(reinterpret_cast<const char*>(m_doc_buffer.data()),
+                  m_doc_buffer.size());
+    m_positions.write(reinterpret_cast<const char*>(m_pos_buffer.data()),
+                      m_pos_buffer.size());
+
+    // IDs are assigned in sorted order
+    m_term_infos.push_back({m_terms.size(), doc_vec.size(), m_offset,
+                            m_doc_buffer.size(), m_pos_offset,
+                            m_pos_buffer.size()});
+    m_terms.push_back(term);
+    m_offset += m_doc_buffer.size();
+    m_pos_offset += m_pos_buffer.size();
+}
+
+void ir::IndexWriter::finish() {
+    m_index << std::flush;
+    m_positions << std::flush;
+    if (!m_index || !m_positions) {
+        throw std::runtime_error("Could not write the index files in " + m_dir);
+    }
+    m_index.close();
+    m_positions.close();
+
+    std::vector<uint8_t> buffer;
+    encode_dictionary(m_terms, m_term_infos, buffer);
+    write_binary_file(m_dir + '/' + DICT_FILE, DICT_MAGIC, buffer);
+
+    buffer.clear();
+    encode_term_hash(m_terms, m_term_infos, buffer);
+    write_binary_file(m_dir + '/' + TERM_HASH_FILE, TERM_HASH_MAGIC, buffer);
+}
+
+ir::ShardedIndexWriter::ShardedIndexWriter(
+    const std::vector<std::string>& dirs,
+    const std::vector<size_t>& shard_begins)
+    : m_shard_begins(shard_begins) {
+    assert(!dirs.empty() && shard_begins.size() + 1 == dirs.size());
+    m_writers.reserve(dirs.size());
+    for (const auto& dir : dirs) {
+        m_writers.emplace_back(dir);
+    }
+}
+
+void ir::ShardedIndexWriter::add(
+    const std::string& term,
+    const std::vector<std::pair<size_t, std::vector<size_t>>>& doc_vec) {
+    if (m_writers.size() == 1) {
+        m_writers[0].add(term, doc_vec);
+        return;
+    }
+
+    // the i^th shard holds the documents in
+    // [m_shard_begins[i - 1], m_shard_begins[i])
+    auto begin = doc_vec.begin();
+    for (size_t i = 0; i < m_writers.size(); ++i) {
+        auto end = doc_vec.end();
+        if (i < m_shard_begins.size()) {
+            end = std::lower_bound(
+                begin, doc_vec.end(), m_shard_begins[i],
+                [](const auto& pair, size_t id) { return pair.first < id; });
+        }
+        if (begin != end) {
+            m_part.assign(begin, end);
+            m_writers[i].add(term, m_part);
+        }
+        begin = end;
+    }
+}
+
+void ir::ShardedIndexWriter::finish() {
+    for (auto& writer : m_writers) {
+        writer.finish();
+    }
+}
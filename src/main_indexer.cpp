@@ -15,114 +15,151 @@
  */
 
 #include <algorithm>
-#include <fstream>
+#include <exception>
+#include <future>
 #include <iostream>
+#include <thread>
 #include <tokenizer.hpp>
 
 #include "doc_preprocessor.hpp"
 #include "file_manager.hpp"
+#include "index_builder.hpp"
 #include "parser.hpp"
+#include "thread_pool.hpp"
 
 /**
- * @brief Return an index from document IDs to raw document content constructed
- * from all the documents in the given file_list.
- *
- * @param file_list vector of document paths containing the individual
- * documents to be extracted using ir::parse_file.
- *
- * @return Mapping from document ID to raw document content.
+ * @brief Number of documents tokenized by a single task of the ingestion
+ * pipeline.
  */
-ir::raw_doc_index docs_from_files(const std::vector<std::string>& file_list) {
-    ir::raw_doc_index all_docs;
-    for (const auto& filepath : file_list) {
-        std::ifstream ifs(filepath);
-        // get all the docs in the current file
-        auto docs_per_file = ir::parse_file(ifs);
-        // store all the docs in the result variable
-        all_docs.insert(docs_per_file.begin(), docs_per_file.end());
-    }
-
-    return all_docs;
-};
+constexpr size_t DOC_BATCH_SIZE = 64;
 
 /**
- * @brief Return an index from document IDs to vectors of normalized terms in
- * the corresponding documents.
- *
- * @param raw_docs Index from document IDs to raw document content.
- *
- * @return Mapping from document IDs to vectors of normalized terms.
+ * @brief Batch of parsed documents.
  */
-ir::doc_term_index terms_from_raw_docs(ir::Tokenizer& tokenizer,
-                                       const ir::raw_doc_index& raw_docs) {
-    ir::doc_term_index term_docs;
-    for (const auto& pair : raw_docs) {
-        const size_t id = pair.first;
-        const auto& raw_doc = pair.second;
-        // get all the normalized terms in the raw document content and store in
-        // document id
-        term_docs[id] = tokenizer.get_doc_terms(raw_doc);
-    }
-    return term_docs;
-}
+using doc_batch = std::vector<ir::DocView>;
 
 /**
- * @brief Build the positional inverted index from a mapping from document ID
- * to vectors of normalized terms in the corresponding documents.
+ * @brief Add all the documents in the given file_list to the given builder
+ * using the given number of threads.
  *
- * This function builds the positional inverted index by iterating over all
- * the terms of a document and setting the document id of each of those terms to
- * the current document. Position of each term is assigned to its index in the
- * term vector of its corresponding document.
+ * Each data file is parsed by a task of a work-stealing ir::ThreadPool with an
+ * ir::DocReader. The parsed documents, which are slices of the mapped file,
+ * are handed out in batches of DOC_BATCH_SIZE documents as subtasks which
+ * handle html character sequences and tokenize the documents.
+ * A worker runs the batches of its own file first, so only a few files are in
+ * memory at a time, while idle workers steal batches instead of waiting for
+ * a large file. Every worker has its own Tokenizer, whose statistics are
+ * merged into tokenizer at the end. The tokenizers intern the terms into
+ * term_pool, and the workers invert the documents by term ID as well, into
+ * the term partitions of the builder.
  *
- * After this procedure, document vector of each term in the resulting index
- * is sorted with respect to the document id.
- *
- * @param term_docs Mapping from document IDs to vectors of normalized terms.
+ * @param file_list vector of document paths containing the individual
+ * documents to be extracted using ir::DocReader.
+ * @param thread_count Number of worker threads.
+ * @param tokenizer Tokenizer receiving the statistics of all the documents.
+ * @param term_pool Pool of the terms, shared with the builder.
+ * @param builder Builder of the segment the documents are added to.
  *
- * @return Positional inverted index.
+ * @throws std::runtime_error If a data file cannot be read or a run of the
+ * builder cannot be written.
  */
-ir::pos_inv_index build_pos_inv_index(const ir::doc_term_index& term_docs) {
-    ir::pos_inv_index result;
-
-    for (const auto& pair : term_docs) {
-        size_t doc_id = pair.first;
-        const auto& term_vec = pair.second;
-
-        for (size_t i = 0; i < term_vec.size(); ++i) {
-            const std::string& term = term_vec[i].first;
-            size_t pos = term_vec[i].second;
-            auto& doc_to_pos = result[term];
-
-            // find pos index of the corresponding document
-            auto doc_of_term_it = std::find_if(
-                doc_to_pos.begin(), doc_to_pos.end(),
-                [doc_id](const std::pair<size_t, std::vector<size_t>>& elem) {
-                    return elem.first == doc_id;
-                });
-
-            if (doc_of_term_it == doc_to_pos.end()) {
-                // no pos list for the doc; create one
-                doc_to_pos.emplace_back(doc_id, std::vector<size_t>());
-                // add the pos to the pos list
-                doc_to_pos.back().second.push_back(pos);
-            } else {
-                // pos list exists for current doc; add the pos
-                doc_of_term_it->second.push_back(pos);
+void index_files(const std::vector<std::string>& file_list,
+                 size_t thread_count, ir::Tokenizer& tokenizer,
+                 ir::TermPool& term_pool, ir::IndexBuilder& builder) {
+    std::vector<ir::Tokenizer> tokenizers(
+        std::max<size_t>(thread_count, 1),
+        ir::Tokenizer(ir::DEFAULT_NORMALIZATION_CACHE_SIZE,
+                      tokenizer.stats_options(), &term_pool));
+    // the pool is destroyed last, so every task must have finished before
+    // this function returns, even on errors; otherwise the destructor would
+    // run tasks referring to the tokenizers and lambdas of this function
+    // after they are gone
+    ir::ThreadPool pool(tokenizers.size());
+
+    auto index_batch = [&pool, &tokenizers, &builder](doc_batch& batch) {
+        auto& local_tokenizer = tokenizers[pool.worker_index()];
+        ir::raw_doc doc;
+        std::vector<std::pair<uint32_t, size_t>> terms;
+        for (const auto& doc_view : batch) {
+            // copy the document handling special html character sequences
+            doc.clear();
+            ir::convert_html_special_chars(doc_view.title, doc);
+            doc += '\n';
+            ir::convert_html_special_chars(doc_view.body, doc);
+            // get the IDs of all the normalized terms and their positions
+            local_tokenizer.get_doc_term_ids(doc, terms);
+            builder.add_document(doc_view.id, terms);
+        }
+    };
+
+    // batches are submitted from the worker parsing the file; their futures
+    // are waited for on this thread, since a worker waiting for a task queued
+    // behind it would never wake up. A file that cannot be parsed still
+    // returns the futures of the batches submitted before the error
+    using parsed_file =
+        std::pair<std::vector<std::future<void>>, std::exception_ptr>;
+    auto parse_file = [&pool, &index_batch](const std::string& filepath) {
+        parsed_file result;
+        auto& batch_futures = result.first;
+        try {
+            // the batches point into the mapping of the file, which is
+            // released after the last batch is indexed
+            auto reader = std::make_shared<ir::DocReader>(filepath);
+            auto submit_batch = [&](doc_batch& batch) {
+                batch_futures.push_back(pool.submit(
+                    [&index_batch, reader, batch = std::move(batch)]() mutable {
+                        index_batch(batch);
+                    }));
+                batch.clear();
+            };
+
+            ir::DocView doc;
+            doc_batch batch;
+            while (reader->next(doc)) {
+                batch.push_back(doc);
+                if (batch.size() == DOC_BATCH_SIZE) {
+                    submit_batch(batch);
+                }
+            }
+            if (!batch.empty()) {
+                submit_batch(batch);
             }
+        } catch (...) {
+            result.second = std::current_exception();
         }
+        return result;
+    };
+
+    std::vector<std::future<parsed_file>> file_futures;
+    for (const auto& filepath : file_list) {
+        file_futures.push_back(pool.submit(
+            [&parse_file, &filepath]() { return parse_file(filepath); }));
     }
 
-    // sort doc list of each term with respect to doc_id
-    for (auto& pair : result) {
-        auto& doc_vec = pair.second;
-        std::sort(doc_vec.begin(), doc_vec.end(),
-                  [](const auto& left, const auto& right) {
-                      return left.first < right.first;
-                  });
+    // wait for all the tasks before reporting the first error
+    std::exception_ptr error;
+    for (auto& file_future : file_futures) {
+        auto result = file_future.get();
+        if (result.second && !error) {
+            error = result.second;
+        }
+        for (auto& batch_future : result.first) {
+            try {
+                batch_future.get();
+            } catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
     }
 
-    return result;
+    for (const auto& local_tokenizer : tokenizers) {
+        tokenizer.merge_stats(local_tokenizer);
+    }
 }
 
 /**
@@ -140,58 +177,224 @@ void print_stats(std::ostream& os, const ir::Tokenizer::Stats& stats) {
        << stats.total_unnormalized_tokens << std::endl;
     os << "Total number of tokens in the corpus after normalization:\t"
        << stats.total_normalized_tokens << std::endl;
-    os << "Total number of terms in the corpus before normalization:\t"
-       << stats.total_unnormalized_terms << std::endl;
-    os << "Total number of terms in the corpus after normalization:\t"
-       << stats.total_normalized_terms << std::endl;
-
-    os << "Top 20 most frequent terms before normalization:\n";
-    for (const std::string& token : stats.top_unnormalized_terms) {
-        os << token << '\n';
+    if (stats.mode == ir::StatsMode::Off) {
+        os << "Term statistics were not collected." << std::endl;
+    } else {
+        if (stats.mode == ir::StatsMode::Approximate) {
+            os << "Term counts and most frequent terms are approximate."
+               << std::endl;
+        }
+        os << "Total number of terms in the corpus before normalization:\t"
+           << stats.total_unnormalized_terms << std::endl;
+        os << "Total number of terms in the corpus after normalization:\t"
+           << stats.total_normalized_terms << std::endl;
+
+        os << "Top 20 most frequent terms before normalization:\n";
+        for (const std::string& token : stats.top_unnormalized_terms) {
+            os << token << '\n';
+        }
+        os << std::endl;
+        os << "Top 20 most frequent terms after normalization:\n";
+        for (const std::string& term : stats.top_normalized_terms) {
+            os << term << '\n';
+        }
     }
     os << std::endl;
-    os << "Top 20 most frequent terms after normalization:\n";
-    for (const std::string& term : stats.top_normalized_terms) {
-        os << term << '\n';
+    os << "Normalization cache hits:\t" << stats.cache_hits << std::endl;
+    os << "Normalization cache misses:\t" << stats.cache_misses << std::endl;
+}
+
+/**
+ * @brief Return the data files that are not in the index yet.
+ *
+ * @param file_list Data files as returned by ir::get_data_file_list.
+ * @param manifest Manifest of the index.
+ *
+ * @return Files of file_list that are not listed in manifest.
+ */
+std::vector<std::string> new_files(const std::vector<std::string>& file_list,
+                                   const ir::Manifest& manifest) {
+    std::vector<std::string> result;
+    for (const auto& file : file_list) {
+        if (std::find(manifest.files.begin(), manifest.files.end(), file) ==
+            manifest.files.end()) {
+            result.push_back(file);
+        }
     }
-    os << std::endl;
+    return result;
+}
+
+/**
+ * @brief Parse a positive integer command line argument.
+ *
+ * @param arg Command line argument.
+ * @param value Output value of the argument.
+ *
+ * @return true if arg is a positive integer; false, otherwise.
+ */
+bool parse_positive(const std::string& arg, size_t& value) {
+    if (arg.empty() || arg.size() > 9 ||
+        !std::all_of(arg.begin(), arg.end(), isdigit) || std::stoul(arg) == 0) {
+        return false;
+    }
+    value = std::stoul(arg);
+    return true;
+}
+
+/**
+ * @brief Parse a statistics mode command line argument.
+ *
+ * @param arg Command line argument; one of exact, approximate and off.
+ * @param mode Output mode of the argument.
+ *
+ * @return true if arg is a statistics mode; false, otherwise.
+ */
+bool parse_stats_mode(const std::string& arg, ir::StatsMode& mode) {
+    if (arg == "exact") {
+        mode = ir::StatsMode::Exact;
+    } else if (arg == "approximate") {
+        mode = ir::StatsMode::Approximate;
+    } else if (arg == "off") {
+        mode = ir::StatsMode::Off;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse the command line arguments of indexer.
+ *
+ * The supported arguments are <tt>-m MiB</tt> giving the memory budget of
+ * the index construction in mebibytes, <tt>-s N</tt> giving the number of
+ * shards the new documents are split into, <tt>-j N</tt> giving the number
+ * of threads parsing and tokenizing the documents and <tt>-t MODE</tt>
+ * giving how the term statistics are gathered; see ir::StatsMode.
+ *
+ * @param memory_budget Output memory budget in bytes; unchanged if not given.
+ * @param shard_count Output number of shards; unchanged if not given.
+ * @param thread_count Output number of threads; unchanged if not given.
+ * @param stats_mode Output statistics mode; unchanged if not given.
+ *
+ * @return true if the arguments are valid; false, otherwise.
+ */
+bool parse_args(int argc, char** argv, size_t& memory_budget,
+                size_t& shard_count, size_t& thread_count,
+                ir::StatsMode& stats_mode) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 == argc) {
+            return false;
+        }
+
+        const std::string value = argv[++i];
+        if (arg == "-m" && parse_positive(value, memory_budget)) {
+            memory_budget *= 1024 * 1024;
+        } else if (!(arg == "-s" && parse_positive(value, shard_count)) &&
+                   !(arg == "-j" && parse_positive(value, thread_count)) &&
+                   !(arg == "-t" && parse_stats_mode(value, stats_mode))) {
+            return false;
+        }
+    }
+    return true;
 }
 
 /**
  * @brief Main routine to parse Reuters sgm files, build the positional inverted
- * index and write the dictionary to ir::DICT_PATH and the index to
- * ir::INDEX_PATH.
+ * index of the files that are not indexed yet and add it to the index under
+ * ir::INDEX_DIR as a new segment.
+ *
+ * Existing segments are never rewritten by adding documents; instead, small
+ * segments are merged by an ir::SegmentMerger in the background while the new
+ * segment is built. Hence, the cost of indexing is proportional to the size
+ * of the new documents.
  *
- * @return 0 if successful.
+ * The new segment is built by an ir::IndexBuilder, so memory usage is bounded
+ * by the memory budget given with <tt>-m MiB</tt> (ir::DEFAULT_MEMORY_BUDGET
+ * by default) rather than by the size of the corpus. With <tt>-s N</tt>, the
+ * new documents are split into N segments by document ID range, which the
+ * searcher queries in parallel; each shard is merged only with segments of
+ * the same shard. Documents are parsed and tokenized in parallel by
+ * <tt>-j N</tt> threads, one per core by default. The term statistics are
+ * counted exactly unless <tt>-t approximate</tt> or <tt>-t off</tt> is
+ * given.
+ *
+ * @return 0 if successful, -1 if the index could not be written, -2 if there
+ * was a problem with command line arguments.
  */
-int main() {
-    std::cerr << "Building the index..." << std::flush;
-    ir::Tokenizer tokenizer;
-    // parse the files and read the docs
-    auto raw_docs = docs_from_files(ir::get_data_file_list());
-
-    // handle special html character sequences
-    for (auto& pair : raw_docs) {
-        auto& doc = pair.second;
-        ir::convert_html_special_chars(doc);
+int main(int argc, char** argv) {
+    size_t memory_budget = ir::DEFAULT_MEMORY_BUDGET;
+    size_t shard_count = 1;
+    size_t thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    ir::StatsOptions stats_options;
+    if (!parse_args(argc, argv, memory_budget, shard_count, thread_count,
+                    stats_options.mode)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [-m memory_budget_in_MiB] [-s shard_count]"
+                     " [-j thread_count] [-t exact|approximate|off]"
+                  << std::endl;
+        return -2;
     }
 
-    // tokenize and normalize the documents
-    auto term_docs = terms_from_raw_docs(tokenizer, raw_docs);
+    ir::Manifest manifest;
+    try {
+        manifest = ir::read_manifest();
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    const auto file_list = new_files(ir::get_data_file_list(), manifest);
 
-    // build the positional inverted index
-    auto inverted_index = build_pos_inv_index(term_docs);
+    ir::Tokenizer tokenizer(ir::DEFAULT_NORMALIZATION_CACHE_SIZE,
+                            stats_options);
+    try {
+        ir::SegmentMerger merger(manifest);
 
-    std::cerr << "OK!" << std::endl;
-    std::cerr << "Writing index files..." << std::flush;
+        if (file_list.empty()) {
+            std::cerr << "Index is up to date." << std::endl;
+        } else {
+            std::cerr << "Building the index..." << std::flush;
 
-    // save the positional inverted index as two files
-    ir::write_dict_file(inverted_index);
-    ir::write_index_file(inverted_index);
+            // invert the documents as they are read
+            const std::string name = merger.new_segment();
+            ir::TermPool term_pool;
+            ir::IndexBuilder builder(ir::segment_dir(name), memory_budget,
+                                     manifest.common_terms, term_pool);
+            index_files(file_list, thread_count, tokenizer, term_pool,
+                        builder);
 
-    std::cerr << "OK!" << std::endl;
+            // the shards become visible to the searcher once they are
+            // committed to the manifest
+            std::vector<ir::SegmentInfo> shards;
+            std::vector<std::string> dirs;
+            shard_count = std::min(shard_count, builder.doc_count());
+            for (size_t i = 0; i < shard_count; ++i) {
+                shards.push_back({i == 0 ? name : merger.new_segment(), 0, i});
+                dirs.push_back(ir::segment_dir(shards.back().name));
+            }
+            if (!dirs.empty()) {
+                const auto doc_counts = builder.finish(dirs);
+                for (size_t i = 0; i < shard_count; ++i) {
+                    shards[i].doc_count = doc_counts[i];
+                }
+            }
+            merger.commit(shards, file_list, builder.common_terms());
 
-    print_stats(std::cerr, tokenizer.stats());
+            std::cerr << "OK!" << std::endl;
+        }
+
+        std::cerr << "Merging segments..." << std::flush;
+        merger.finish();
+        std::cerr << "OK!" << std::endl;
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+
+    // statistics cover the documents added by this run
+    if (!file_list.empty()) {
+        print_stats(std::cerr, tokenizer.stats());
+    }
 
     return 0;
 }
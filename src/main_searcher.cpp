@@ -19,8 +19,17 @@
 #include "tokenizer.hpp"
 #include <algorithm>
 #include <iostream>
+#include <thread>
 #include <util.hpp>
 
+/**
+ * @brief Normalization cache capacity of the tokenizers of the queries.
+ *
+ * A query has only a few words, so a cache would cost far more to allocate
+ * than it saves.
+ */
+constexpr size_t QUERY_CACHE_CAPACITY = 0;
+
 /**
  * @brief Tokenize conjunctive query by finding the query keywords and returning
  * the normalized versions of the keywords using ir::normalize.
@@ -63,7 +72,7 @@ std::vector<std::string> tokenize_conjunctive_query(const std::string& query) {
     }
 
     // normalize words
-    ir::Tokenizer tokenizer;
+    ir::Tokenizer tokenizer(QUERY_CACHE_CAPACITY);
     tokenizer.normalize_all(words);
     return words;
 }
@@ -93,7 +102,7 @@ std::vector<std::string> tokenize_phrase_query(const std::string& query) {
     std::vector<std::string> words = ir::split(query_search_part, " ");
 
     // normalize words
-    ir::Tokenizer tokenizer;
+    ir::Tokenizer tokenizer(QUERY_CACHE_CAPACITY);
     tokenizer.normalize_all(words);
     return words;
 }
@@ -150,7 +159,7 @@ tokenize_proximity_query(const std::string& query) {
         }
     }
 
-    ir::Tokenizer tokenizer;
+    ir::Tokenizer tokenizer(QUERY_CACHE_CAPACITY);
     bool contain_stopword = std::any_of(words.begin(), words.end(),
                                         [&tokenizer](const std::string& word) {
                                             return tokenizer.is_stopword(word);
@@ -179,8 +188,11 @@ int main(int argc, char** argv) {
     std::cerr << "Reading index files..." << std::flush;
     ir::QueryProcessor query_processor;
     try {
+        // search the segments in parallel on all the cores
+        const auto manifest = ir::read_manifest();
         query_processor =
-            ir::QueryProcessor(ir::read_dict_file(), ir::read_index_file());
+            ir::QueryProcessor(ir::read_index(manifest), manifest.common_terms,
+                               std::thread::hardware_concurrency());
     } catch (const std::runtime_error& e) {
         std::cerr << e.what() << std::endl;
         return -1;
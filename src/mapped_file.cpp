@@ -0,0 +1,82 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_file.hpp"
+#include <stdexcept>
+#include <utility>
+
+ir::MappedFile::MappedFile(const std::string& path, AccessPattern pattern) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error(path + " does not exist in the current folder!");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        throw std::runtime_error("Could not stat " + path);
+    }
+    m_size = static_cast<size_t>(st.st_size);
+
+    // mmap of an empty file is an error; leave the mapping empty instead
+    if (m_size != 0) {
+        void* addr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Could not map " + path);
+        }
+        m_data = static_cast<const char*>(addr);
+
+        if (pattern == AccessPattern::Sequential) {
+            madvise(addr, m_size, MADV_SEQUENTIAL);
+        } else if (pattern == AccessPattern::Random) {
+            madvise(addr, m_size, MADV_RANDOM);
+        }
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+ir::MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_data(other.m_data), m_size(other.m_size) {
+    other.m_data = nullptr;
+    other.m_size = 0;
+}
+
+ir::MappedFile& ir::MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+    }
+    return *this;
+}
+
+ir::MappedFile::~MappedFile() { unmap(); }
+
+void ir::MappedFile::unmap() {
+    if (m_data != nullptr) {
+        munmap(const_cast<char*>(m_data), m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
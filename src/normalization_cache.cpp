@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "normalization_cache.hpp"
+#include "hash.hpp"
+
+/**
+ * @brief Return the smallest power of two that is at least twice the given
+ * capacity, so that the table is at most half full.
+ */
+static size_t slot_count_of(size_t capacity) {
+    size_t slot_count = 1;
+    while (slot_count < 2 * capacity) {
+        slot_count *= 2;
+    }
+    return slot_count;
+}
+
+ir::NormalizationCache::NormalizationCache(size_t capacity)
+    : m_capacity(capacity) {}
+
+const ir::NormalizationCache::Entry*
+ir::NormalizationCache::find(std::string_view token) const {
+    if (m_slots.empty()) {
+        return nullptr;
+    }
+
+    const uint64_t hash = hash_bytes(token.data(), token.size());
+    const size_t mask = m_slots.size() - 1;
+    // the table always has free slots, so probing terminates
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const auto& slot = m_slots[i];
+        if (slot.token.empty()) {
+            return nullptr;
+        }
+        if (slot.hash == hash && slot.token == token) {
+            return &slot.entry;
+        }
+    }
+}
+
+void ir::NormalizationCache::insert(std::string_view token,
+                                    std::string_view term, uint32_t term_id) {
+    if (token.empty() || m_size == m_capacity) {
+        return;
+    }
+    if (m_slots.empty()) {
+        m_slots.resize(slot_count_of(m_capacity));
+    }
+
+    const uint64_t hash = hash_bytes(token.data(), token.size());
+    const size_t mask = m_slots.size() - 1;
+    size_t i = hash & mask;
+    while (!m_slots[i].token.empty()) {
+        i = (i + 1) & mask;
+    }
+    m_slots[i] = {hash, std::string(token), {std::string(term), term_id}};
+    ++m_size;
+}
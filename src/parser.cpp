@@ -15,9 +15,39 @@
  */
 
 #include "parser.hpp"
+#include "char_class.hpp"
+#include "tag_scanner.hpp"
 
+#include <algorithm>
 #include <cassert>
-#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @brief Return the position of the end of the line containing the given
+ * position, i.e. of its newline character or the end of the text.
+ */
+static size_t line_end(std::string_view text, size_t pos) {
+    const size_t end = text.find('\n', pos);
+    return end == std::string_view::npos ? text.size() : end;
+}
+
+/**
+ * @brief Return the position of the first line of the given text that starts
+ * with the given tag; std::string_view::npos if there is no such line.
+ *
+ * The text must begin at the beginning of a line.
+ */
+static size_t find_line_starting_with(std::string_view text,
+                                      std::string_view tag) {
+    for (size_t pos = ir::find_tag(text, tag); pos != std::string_view::npos;
+         pos = ir::find_tag(text, tag, pos + 1)) {
+        if (pos == 0 || text[pos - 1] == '\n') {
+            return pos;
+        }
+    }
+    return std::string_view::npos;
+}
 
 /**
  * @brief Get the ID of a document with the given header line.
@@ -31,113 +61,104 @@
  *
  * @return ID of the document.
  */
-int get_doc_id(const std::string& header_line) {
-    // header start index
-    size_t newid_pos = header_line.find(ir::ID_FIELD);
+static size_t get_doc_id(std::string_view header_line) {
     // number beginning index
-    size_t num_beg_pos = newid_pos + ir::ID_FIELD.size();
-    // number end index
-    size_t num_end_pos = header_line.find('\"', num_beg_pos);
-
-    std::string num_str =
-        header_line.substr(num_beg_pos, num_end_pos - num_beg_pos);
+    size_t pos = header_line.find(ir::ID_FIELD);
+    if (pos == std::string_view::npos) {
+        return 0;
+    }
+    pos += ir::ID_FIELD.size();
 
-    return std::atoi(num_str.c_str());
+    size_t id = 0;
+    for (; pos < header_line.size() && ir::is_digit(header_line[pos]); ++pos) {
+        id = 10 * id + static_cast<size_t>(header_line[pos] - '0');
+    }
+    return id;
 }
 
 /**
- * @brief Find the next document in the input stream and return its raw content.
- *
- * Raw content of a document is defined as the text inside its ir::TXT_BEG_TAG
- * and ir::TXT_END_TAG s.
+ * @brief Return the slice between the given positions of a beginning and an
+ * end tag excluding the tags themselves.
  *
- * This function finds the next ir::TXT_BEG_TAG in the input stream and gets all
- * the text until ir::TXT_END_TAG is encountered.
- *
- * @param ifs Input stream from which next raw document will be extracted.
- *
- * @return Raw content of the next document in the input stream.
- *
- * @throws std::invalid_argument if input stream doesn't contain ir::TXT_BEG_TAG
- * and ir::TXT_END_TAG fields.
+ * If the beginning tag was not found, an empty slice is returned. If the end
+ * tag was not found, an assertion error is given.
  */
-ir::raw_doc get_next_doc(std::istream& ifs) {
-    std::string line;
-    size_t beg_header_pos;
-    size_t end_header_pos;
-    while (std::getline(ifs, line)) {
-        beg_header_pos = line.find(ir::TXT_BEG_TAG);
-        // if current line contains TXT_BEG_TAG
-        if (beg_header_pos != std::string::npos) {
-            std::string text;
-
-            // read all the text until TXT_END_TAG is encountered
-            do {
-                std::getline(ifs, line);
-                end_header_pos = line.find(ir::TXT_END_TAG);
-                text += "\n" + line.substr(0, end_header_pos);
-            } while (end_header_pos == std::string::npos);
-
-            return text;
-        }
+static std::string_view slice_between(std::string_view text, size_t beg_pos,
+                                      std::string_view beg_tag,
+                                      size_t end_pos) {
+    if (beg_pos == std::string_view::npos) {
+        return std::string_view();
     }
-    // we should never come here if the input is proper
-    throw std::invalid_argument("Input stream does not contain " +
-                                ir::TXT_BEG_TAG + " and " + ir::TXT_END_TAG +
-                                " fields");
+    assert(end_pos != std::string_view::npos);
+
+    // don't include the tag itself
+    const size_t beg_index = beg_pos + beg_tag.size();
+    return text.substr(beg_index, end_pos - beg_index);
 }
 
-/**
- * @brief Return the text between given tags.
- *
- * This function finds and returns the text between given two tags in the
- * given document. This is done by finding the positions of beg_tag and end_tag
- * and returning the substring between indices adjusted to exclude tags
- * themselves.
- *
- * If beg_tag is not in doc_text, then empty string is returned.
- * If end_tag is not in doc_text, then an assertion error is given.
- *
- * @param doc_text Text containing beg_tag and end_tag
- * @param beg_tag Beginning tag.
- * @param end_tag End tag.
- *
- * @return The text between beg_tag and end_tag.
- */
-std::string text_between_tags(const std::string& doc_text,
-                              const std::string& beg_tag,
-                              const std::string& end_tag) {
-    size_t tag_beg_pos = doc_text.find(beg_tag);
-    // if no beg_tag, return empty string
-    if (tag_beg_pos == std::string::npos) {
-        return "";
+ir::DocReader::DocReader(const std::string& path)
+    : m_file(path, MappedFile::AccessPattern::Sequential),
+      m_rest(m_file.data(), m_file.size()) {}
+
+bool ir::DocReader::next(DocView& doc) {
+    const size_t header_pos = find_line_starting_with(m_rest, DOC_HEADER);
+    if (header_pos == std::string_view::npos) {
+        m_rest = std::string_view();
+        return false;
     }
+    const size_t header_end = line_end(m_rest, header_pos);
+    doc.id = get_doc_id(m_rest.substr(header_pos, header_end - header_pos));
 
-    size_t tag_end_pos = doc_text.find(end_tag);
-    assert(tag_end_pos != std::string::npos);
+    // raw content of a document starts on the line after ir::TXT_BEG_TAG and
+    // ends at ir::TXT_END_TAG
+    const size_t txt_beg_pos = find_tag(m_rest, TXT_BEG_TAG, header_end);
+    if (txt_beg_pos == std::string_view::npos) {
+        throw std::invalid_argument("Document " + std::to_string(doc.id) +
+                                    " does not contain " + TXT_BEG_TAG);
+    }
+    const size_t text_beg = line_end(m_rest, txt_beg_pos);
 
-    // don't include the tag itself
-    size_t beg_index = tag_beg_pos + beg_tag.size();
-    size_t len = tag_end_pos - beg_index;
+    // locate the first occurrence of each tag in a single pass over the tags
+    // of the text, which ends at ir::TXT_END_TAG
+    const size_t npos = std::string_view::npos;
+    size_t title_beg = npos, title_end = npos, body_beg = npos, body_end = npos;
+    std::pair<const std::string*, size_t*> tags[] = {
+        {&TITLE_BEG_TAG, &title_beg},
+        {&TITLE_END_TAG, &title_end},
+        {&BODY_BEG_TAG, &body_beg},
+        {&BODY_END_TAG, &body_end}};
+    size_t text_end = find_tag_open(m_rest, text_beg);
+    for (; text_end != npos && !tag_at(m_rest, text_end, TXT_END_TAG);
+         text_end = find_tag_open(m_rest, text_end + 1)) {
+        for (auto& tag : tags) {
+            if (*tag.second == npos && tag_at(m_rest, text_end, *tag.first)) {
+                *tag.second = text_end;
+                break;
+            }
+        }
+    }
+    if (text_end == npos) {
+        throw std::invalid_argument("Document " + std::to_string(doc.id) +
+                                    " does not contain " + TXT_END_TAG);
+    }
 
-    return doc_text.substr(beg_index, len);
+    doc.title = slice_between(m_rest, title_beg, TITLE_BEG_TAG, title_end);
+    doc.body = slice_between(m_rest, body_beg, BODY_BEG_TAG, body_end);
+
+    // continue from the line after ir::TXT_END_TAG
+    const size_t next_line = line_end(m_rest, text_end) + 1;
+    m_rest.remove_prefix(std::min(next_line, m_rest.size()));
+    return true;
 }
 
-ir::raw_doc_index ir::parse_file(std::istream& ifs) {
+ir::raw_doc_index ir::parse_file(const std::string& path) {
     raw_doc_index docs;
-    std::string line;
-
-    int id;
-    raw_doc doc;
-    while (std::getline(ifs, line)) {
-        if (line.find(DOC_HEADER) == 0) {
-            id = get_doc_id(line);
-            doc = get_next_doc(ifs);
-            doc = text_between_tags(doc, TITLE_BEG_TAG, TITLE_END_TAG) + "\n" +
-                  text_between_tags(doc, BODY_BEG_TAG, BODY_END_TAG);
-            docs[id] = doc;
-        }
+
+    DocReader reader(path);
+    DocView doc;
+    while (reader.next(doc)) {
+        docs[doc.id] = doc.text();
     }
 
     return docs;
-};
+}
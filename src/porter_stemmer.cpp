@@ -37,10 +37,11 @@
        steps after step1ab unless k > k0.
 */
 
+#include "porter_stemmer.hpp"
 #include <string.h>  /* for memmove */
 
-#define TRUE 1
-#define FALSE 0
+#define TRUE true
+#define FALSE false
 
 /* The main part of the stemming algorithm starts here. b is a buffer
    holding a word to be stemmed. The letters are in b[k0], b[k0+1] ...
@@ -52,12 +53,12 @@
    should be done before stem(...) is called.
 */
 
-static char * b;       /* buffer for word to be stemmed */
-static int k,k0,j;     /* j is a general offset into the string */
+/* b, k, k0 and j are members of ir::PorterStemmer rather than statics, so
+   that words can be stemmed on several threads with separate stemmers. */
 
 /* cons(i) is TRUE <=> b[i] is a consonant. */
 
-static int cons(int i)
+bool ir::PorterStemmer::cons(int i) const
 {  switch (b[i])
     {  case 'a': case 'e': case 'i': case 'o': case 'u': return FALSE;
         case 'y': return (i==k0) ? TRUE : !cons(i-1);
@@ -76,7 +77,7 @@ static int cons(int i)
       ....
 */
 
-static int m()
+int ir::PorterStemmer::m() const
 {  int n = 0;
     int i = k0;
     while(TRUE)
@@ -103,14 +104,14 @@ static int m()
 
 /* vowelinstem() is TRUE <=> k0,...j contains a vowel */
 
-static int vowelinstem()
+bool ir::PorterStemmer::vowelinstem() const
 {  int i; for (i = k0; i <= j; i++) if (! cons(i)) return TRUE;
     return FALSE;
 }
 
 /* doublec(j) is TRUE <=> j,(j-1) contain a double consonant. */
 
-static int doublec(int j)
+bool ir::PorterStemmer::doublec(int j) const
 {  if (j < k0+1) return FALSE;
     if (b[j] != b[j-1]) return FALSE;
     return cons(j);
@@ -125,7 +126,7 @@ static int doublec(int j)
 
 */
 
-static int cvc(int i)
+bool ir::PorterStemmer::cvc(int i) const
 {  if (i < k0+2 || !cons(i) || cons(i-1) || !cons(i-2)) return FALSE;
     {  int ch = b[i];
         if (ch == 'w' || ch == 'x' || ch == 'y') return FALSE;
@@ -135,7 +136,7 @@ static int cvc(int i)
 
 /* ends(s) is TRUE <=> k0,...k ends with the string s. */
 
-static int ends(char * s)
+bool ir::PorterStemmer::ends(const char * s)
 {  int length = s[0];
     if (s[length] != b[k]) return FALSE; /* tiny speed-up */
     if (length > k-k0+1) return FALSE;
@@ -147,7 +148,7 @@ static int ends(char * s)
 /* setto(s) sets (j+1),...k to the characters in the string s, readjusting
    k. */
 
-static void setto(char * s)
+void ir::PorterStemmer::setto(const char * s)
 {  int length = s[0];
     memmove(b+j+1,s+1,length);
     k = j+length;
@@ -155,7 +156,7 @@ static void setto(char * s)
 
 /* r(s) is used further down. */
 
-static void r(char * s) { if (m() > 0) setto(s); }
+void ir::PorterStemmer::r(const char * s) { if (m() > 0) setto(s); }
 
 /* step1ab() gets rid of plurals and -ed or -ing. e.g.
 
@@ -179,7 +180,7 @@ static void r(char * s) { if (m() > 0) setto(s); }
 
 */
 
-static void step1ab()
+void ir::PorterStemmer::step1ab()
 {  if (b[k] == 's')
     {  if (ends("\04" "sses")) k -= 2; else
         if (ends("\03" "ies")) setto("\01" "i"); else
@@ -203,14 +204,14 @@ static void step1ab()
 
 /* step1c() turns terminal y to i when there is another vowel in the stem. */
 
-static void step1c() { if (ends("\01" "y") && vowelinstem()) b[k] = 'i'; }
+void ir::PorterStemmer::step1c() { if (ends("\01" "y") && vowelinstem()) b[k] = 'i'; }
 
 
 /* step2() maps double suffices to single ones. so -ization ( = -ize plus
    -ation) maps to -ize etc. note that the string before the suffix must give
    m() > 0. */
 
-static void step2() { switch (b[k-1])
+void ir::PorterStemmer::step2() { switch (b[k-1])
     {
         case 'a': if (ends("\07" "ational")) { r("\03" "ate"); break; }
             if (ends("\06" "tional")) { r("\04" "tion"); break; }
@@ -251,7 +252,7 @@ static void step2() { switch (b[k-1])
 
 /* step3() deals with -ic-, -full, -ness etc. similar strategy to step2. */
 
-static void step3() { switch (b[k])
+void ir::PorterStemmer::step3() { switch (b[k])
     {
         case 'e': if (ends("\05" "icate")) { r("\02" "ic"); break; }
             if (ends("\05" "ative")) { r("\00" ""); break; }
@@ -268,7 +269,7 @@ static void step3() { switch (b[k])
 
 /* step4() takes off -ant, -ence etc., in context <c>vcvc<v>. */
 
-static void step4()
+void ir::PorterStemmer::step4()
 {  switch (b[k-1])
     {  case 'a': if (ends("\02" "al")) break; return;
         case 'c': if (ends("\04" "ance")) break;
@@ -298,7 +299,7 @@ static void step4()
 /* step5() removes a final -e if m() > 1, and changes -ll to -l if
    m() > 1. */
 
-static void step5()
+void ir::PorterStemmer::step5()
 {  j = k;
     if (b[k] == 'e')
     {  int a = m();
@@ -307,18 +308,15 @@ static void step5()
     if (b[k] == 'l' && doublec(k) && m() > 1) k--;
 }
 
-/* In stem(p,i,j), p is a char pointer, and the string to be stemmed is from
-   p[i] to p[j] inclusive. Typically i is zero and j is the offset to the last
-   character of a string, (p[j+1] == '\0'). The stemmer adjusts the
-   characters p[i] ... p[j] and returns the new end-point of the string, k.
-   Stemming never increases word length, so i <= k <= j. To turn the stemmer
-   into a module, declare 'stem' as extern, and delete the remainder of this
-   file.
+/* In stem(p,n), p is a char pointer, and the string to be stemmed is from
+   p[0] to p[n-1] inclusive. The stemmer adjusts the characters p[0] ...
+   p[n-1] and returns the new length of the string, k+1. Stemming never
+   increases word length, so the result is at most n.
 */
 
-int stem(char * p, int i, int j)
-{  b = p; k = j; k0 = i; /* copy the parameters into statics */
-    if (k <= k0+1) return k; /*-DEPARTURE-*/
+size_t ir::PorterStemmer::stem(char * p, size_t n)
+{  b = p; k = static_cast<int>(n) - 1; k0 = 0; /* copy the parameters into members */
+    if (k <= k0+1) return n; /*-DEPARTURE-*/
 
     /* With this line, strings of length 1 or 2 don't go through the
        stemming process, although no mention is made of this in the
@@ -329,5 +327,5 @@ int stem(char * p, int i, int j)
     if (k > k0) {
         step1c(); step2(); step3(); step4(); step5();
     }
-    return k;
+    return static_cast<size_t>(k + 1);
 }
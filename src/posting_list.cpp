@@ -0,0 +1,350 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "posting_list.hpp"
+#include "varint.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+/**
+ * @brief Pack ir::BLOCK_SIZE integers using the given bit width and append
+ * the result to out.
+ *
+ * @param in ir::BLOCK_SIZE integers.
+ * @param bits Bit width that fits all the integers.
+ * @param out Byte vector the packed integers are appended to.
+ */
+static void append_packed(const uint32_t* in, unsigned bits,
+                          std::vector<uint8_t>& out) {
+    const size_t old_size = out.size();
+    out.resize(old_size + ir::packed_block_size(bits));
+    ir::pack_block(in, bits, out.data() + old_size);
+}
+
+/**
+ * @brief Encode a sequence of position gaps and append the result to out.
+ *
+ * Full chunks of ir::BLOCK_SIZE gaps are packed, the rest are varints.
+ *
+ * @param pos_gaps Position gaps of all the documents of a block.
+ * @param out Byte vector the encoded gaps are appended to.
+ */
+static void append_pos_gaps(const std::vector<uint32_t>& pos_gaps,
+                            std::vector<uint8_t>& out) {
+    size_t i = 0;
+    for (; i + ir::BLOCK_SIZE <= pos_gaps.size(); i += ir::BLOCK_SIZE) {
+        const unsigned pos_bits =
+            ir::max_bits(pos_gaps.data() + i, ir::BLOCK_SIZE);
+        out.push_back(static_cast<uint8_t>(pos_bits));
+        append_packed(pos_gaps.data() + i, pos_bits, out);
+    }
+    auto out_it = std::back_inserter(out);
+    for (; i < pos_gaps.size(); ++i) {
+        ir::encode_varint(pos_gaps[i], out_it);
+    }
+}
+
+/**
+ * @brief Append the position gaps of the given document to pos_gaps.
+ */
+static void collect_pos_gaps(const std::vector<size_t>& pos_vec,
+                             std::vector<uint32_t>& pos_gaps) {
+    size_t prev_pos = 0;
+    for (size_t pos : pos_vec) {
+        pos_gaps.push_back(static_cast<uint32_t>(pos - prev_pos));
+        prev_pos = pos;
+    }
+}
+
+/**
+ * @brief Append the given integer to out as 4 little endian bytes.
+ */
+static void append_u32(uint32_t value, std::vector<uint8_t>& out) {
+    for (size_t i = 0; i < sizeof(uint32_t); ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+/**
+ * @brief Read a little endian 4 byte integer from ptr.
+ */
+static uint32_t load_u32(const uint8_t* ptr) {
+    uint32_t value;
+    std::memcpy(&value, ptr, sizeof(uint32_t));
+    return value;
+}
+
+void ir::encode_posting_list(
+    const std::vector<std::pair<size_t, std::vector<size_t>>>& doc_vec,
+    std::vector<uint8_t>& doc_out, std::vector<uint8_t>& pos_out) {
+    std::array<uint32_t, BLOCK_SIZE> doc_gaps;
+    std::array<uint32_t, BLOCK_SIZE> tfs;
+    std::vector<uint32_t> pos_gaps;
+    std::vector<uint8_t> skips;
+    std::vector<uint8_t> blocks;
+    const size_t pos_begin = pos_out.size();
+
+    size_t prev_doc_id = 0;
+    const size_t full_blocks = doc_vec.size() / BLOCK_SIZE;
+    for (size_t block = 0; block < full_blocks; ++block) {
+        // collect the gaps of the documents in the block
+        pos_gaps.clear();
+        for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+            const auto& doc_pair = doc_vec[block * BLOCK_SIZE + i];
+            const auto& pos_vec = doc_pair.second;
+            doc_gaps[i] = static_cast<uint32_t>(doc_pair.first - prev_doc_id);
+            tfs[i] = static_cast<uint32_t>(pos_vec.size() - 1);
+            collect_pos_gaps(pos_vec, pos_gaps);
+            prev_doc_id = doc_pair.first;
+        }
+
+        append_u32(static_cast<uint32_t>(prev_doc_id), skips);
+        append_u32(static_cast<uint32_t>(blocks.size()), skips);
+        append_u32(static_cast<uint32_t>(pos_out.size() - pos_begin), skips);
+
+        const unsigned doc_bits = max_bits(doc_gaps.data(), BLOCK_SIZE);
+        const unsigned tf_bits = max_bits(tfs.data(), BLOCK_SIZE);
+        blocks.push_back(static_cast<uint8_t>(doc_bits));
+        blocks.push_back(static_cast<uint8_t>(tf_bits));
+        append_packed(doc_gaps.data(), doc_bits, blocks);
+        append_packed(tfs.data(), tf_bits, blocks);
+        append_pos_gaps(pos_gaps, pos_out);
+    }
+
+    if (full_blocks != 0) {
+        const size_t last_doc_id = doc_vec.back().first;
+        append_u32(static_cast<uint32_t>(last_doc_id), skips);
+        append_u32(static_cast<uint32_t>(blocks.size()), skips);
+        append_u32(static_cast<uint32_t>(pos_out.size() - pos_begin), skips);
+    }
+
+    // remaining documents
+    auto blocks_it = std::back_inserter(blocks);
+    pos_gaps.clear();
+    for (size_t i = full_blocks * BLOCK_SIZE; i < doc_vec.size(); ++i) {
+        const auto& doc_pair = doc_vec[i];
+        const auto& pos_vec = doc_pair.second;
+        encode_varint(doc_pair.first - prev_doc_id, blocks_it);
+        encode_varint(pos_vec.size(), blocks_it);
+        collect_pos_gaps(pos_vec, pos_gaps);
+        prev_doc_id = doc_pair.first;
+    }
+    append_pos_gaps(pos_gaps, pos_out);
+
+    // dense lists additionally store their documents as a set
+    std::vector<size_t> doc_ids;
+    doc_ids.reserve(doc_vec.size());
+    for (const auto& doc_pair : doc_vec) {
+        doc_ids.push_back(doc_pair.first);
+    }
+    const bool dense = is_dense(doc_ids);
+
+    auto doc_out_it = std::back_inserter(doc_out);
+    encode_varint(doc_vec.size() << 1 | (dense ? 1 : 0), doc_out_it);
+    if (dense) {
+        std::vector<uint8_t> doc_set;
+        encode_doc_set(doc_ids, doc_set);
+        encode_varint(doc_set.size(), doc_out_it);
+        doc_out.insert(doc_out.end(), doc_set.begin(), doc_set.end());
+    }
+    doc_out.insert(doc_out.end(), skips.begin(), skips.end());
+    doc_out.insert(doc_out.end(), blocks.begin(), blocks.end());
+}
+
+ir::PostingList::PostingList(const uint8_t* begin, const uint8_t* end,
+                             const uint8_t* pos_begin)
+    : m_skips(begin), m_end(end), m_positions(pos_begin), m_size(0) {
+    if (m_skips != m_end) {
+        const uint64_t header = decode_varint(m_skips);
+        m_size = header >> 1;
+        if (header & 1) {
+            const size_t doc_set_length = decode_varint(m_skips);
+            m_doc_set = DocSet(m_skips);
+            m_skips += doc_set_length;
+        }
+    }
+}
+
+ir::PostingCursor::PostingCursor(const PostingList& list)
+    : m_skips(list.m_skips), m_blocks(list.m_skips), m_end(list.m_end),
+      m_pos_begin(list.m_positions), m_block_count(list.m_size / BLOCK_SIZE),
+      m_tail_len(list.m_size % BLOCK_SIZE), m_block(0), m_index(0),
+      m_block_len(0), m_pos_ptr(nullptr) {
+    if (m_block_count != 0) {
+        m_blocks += (m_block_count + 1) * SKIP_ENTRY_SIZE;
+    }
+    load_block(0);
+}
+
+uint32_t ir::PostingCursor::skip_last_doc(size_t block) const {
+    return load_u32(m_skips + block * SKIP_ENTRY_SIZE);
+}
+
+void ir::PostingCursor::advance(size_t target) {
+    if (!valid() || doc_id() >= target) {
+        return;
+    }
+
+    if (m_doc_ids[m_block_len - 1] < target) {
+        // gallop over the skip table to bound the first block whose last
+        // document is not less than target
+        const size_t lo = m_block + 1;
+        const size_t hi = std::max(lo, m_block_count);
+        size_t bound = 1;
+        while (lo + bound < hi && skip_last_doc(lo + bound) < target) {
+            bound *= 2;
+        }
+
+        // binary search in the bounded range; if there is no such block, the
+        // result is the tail or the end of the list
+        size_t first = lo + bound / 2;
+        size_t last = std::min(lo + bound + 1, hi);
+        while (first < last) {
+            const size_t mid = first + (last - first) / 2;
+            if (skip_last_doc(mid) < target) {
+                first = mid + 1;
+            } else {
+                last = mid;
+            }
+        }
+
+        load_block(first);
+        if (!valid()) {
+            return;
+        }
+    }
+
+    const auto begin = m_doc_ids.begin() + m_index;
+    const auto end = m_doc_ids.begin() + m_block_len;
+    m_index = std::lower_bound(begin, end, target) - m_doc_ids.begin();
+    if (m_index == m_block_len) {
+        // only possible in the tail, which has no skip entry of its own
+        load_block(m_block + 1);
+    }
+}
+
+void ir::PostingCursor::load_block(size_t block) {
+    m_block = block;
+    m_index = 0;
+    m_block_len = 0;
+    m_pos_gaps.clear();
+    m_positions_index = std::numeric_limits<size_t>::max();
+
+    if (block > m_block_count) {
+        return;
+    }
+
+    // the skip table locates the block in both streams
+    uint32_t base = 0;
+    size_t doc_offset = 0;
+    size_t pos_offset = 0;
+    if (m_block_count != 0) {
+        const uint8_t* entry = m_skips + block * SKIP_ENTRY_SIZE;
+        base = block == 0 ? 0 : skip_last_doc(block - 1);
+        doc_offset = load_u32(entry + sizeof(uint32_t));
+        pos_offset = load_u32(entry + 2 * sizeof(uint32_t));
+    }
+    m_pos_ptr = m_pos_begin + pos_offset;
+
+    if (block < m_block_count) {
+        load_full_block(m_blocks + doc_offset, base);
+    } else {
+        load_tail(m_blocks + doc_offset, base);
+    }
+}
+
+void ir::PostingCursor::load_full_block(const uint8_t* ptr, uint32_t base) {
+    const unsigned doc_bits = *ptr++;
+    const unsigned tf_bits = *ptr++;
+
+    unpack_block(ptr, doc_bits, m_doc_ids.data());
+    prefix_sum_block(m_doc_ids.data(), base);
+    ptr += packed_block_size(doc_bits);
+    assert(m_doc_ids[BLOCK_SIZE - 1] == skip_last_doc(m_block));
+
+    // term frequencies are stored minus one; turn them into the index of the
+    // first position of each document
+    uint32_t* tfs = m_pos_offsets.data() + 1;
+    unpack_block(ptr, tf_bits, tfs);
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        ++tfs[i];
+    }
+    m_pos_offsets[0] = 0;
+    prefix_sum_block(tfs, 0);
+    ptr += packed_block_size(tf_bits);
+    assert(ptr <= m_end);
+
+    m_block_len = BLOCK_SIZE;
+}
+
+void ir::PostingCursor::load_tail(const uint8_t* ptr, uint32_t base) {
+    // the tail is short; decode all the document IDs and frequencies
+    uint32_t doc_id = base;
+    uint32_t pos_count = 0;
+    m_pos_offsets[0] = 0;
+    for (size_t i = 0; i < m_tail_len; ++i) {
+        doc_id += static_cast<uint32_t>(decode_varint(ptr));
+        m_doc_ids[i] = doc_id;
+        pos_count += static_cast<uint32_t>(decode_varint(ptr));
+        m_pos_offsets[i + 1] = pos_count;
+    }
+    assert(ptr == m_end);
+
+    m_block_len = m_tail_len;
+}
+
+void ir::PostingCursor::decode_pos_gaps(size_t count) {
+    const size_t total = m_pos_offsets[m_block_len];
+    while (m_pos_gaps.size() < count) {
+        const size_t decoded = m_pos_gaps.size();
+        if (total - decoded >= BLOCK_SIZE) {
+            const unsigned bits = *m_pos_ptr++;
+            m_pos_gaps.resize(decoded + BLOCK_SIZE);
+            unpack_block(m_pos_ptr, bits, m_pos_gaps.data() + decoded);
+            m_pos_ptr += packed_block_size(bits);
+        } else {
+            // the remaining gaps of the block are varints
+            while (m_pos_gaps.size() < total) {
+                m_pos_gaps.push_back(
+                    static_cast<uint32_t>(decode_varint(m_pos_ptr)));
+            }
+        }
+    }
+}
+
+const std::vector<uint32_t>& ir::PostingCursor::positions() {
+    if (m_positions_index == m_index) {
+        return m_positions;
+    }
+
+    const size_t begin = m_pos_offsets[m_index];
+    const size_t end = m_pos_offsets[m_index + 1];
+    decode_pos_gaps(end);
+
+    // gaps are taken within each document
+    m_positions.resize(end - begin);
+    uint32_t pos = 0;
+    for (size_t i = begin; i < end; ++i) {
+        pos += m_pos_gaps[i];
+        m_positions[i - begin] = pos;
+    }
+    m_positions_index = m_index;
+
+    return m_positions;
+}
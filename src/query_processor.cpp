@@ -15,64 +15,136 @@
  */
 
 #include "query_processor.hpp"
-#include "util.hpp"
+#include "bigram.hpp"
 #include <algorithm>
 #include <cassert>
+#include <utility>
+
+ir::QueryProcessor::QueryProcessor(std::vector<IndexSegment> segments,
+                                   std::vector<std::string> common_terms,
+                                   size_t thread_count)
+    : m_segments(std::move(segments)), m_common_terms(std::move(common_terms)) {
+    thread_count = std::min(thread_count, m_segments.size());
+    if (thread_count > 1) {
+        m_pool = std::make_unique<ThreadPool>(thread_count);
+    }
+}
 
-ir::QueryProcessor::QueryProcessor(const term_id_map& dict,
-                                   const id_pos_map& index)
-    : m_dict(dict), m_index(index) {}
+template <typename Search>
+std::vector<size_t> ir::QueryProcessor::search_segments(Search search) const {
+    std::vector<size_t> result;
+    if (!m_pool) {
+        for (const auto& segment : m_segments) {
+            const auto segment_result = search(segment);
+            result.insert(result.end(), segment_result.begin(),
+                          segment_result.end());
+        }
+        return result;
+    }
+
+    // scatter the segments to the pool and gather the results in order
+    std::vector<std::future<std::vector<size_t>>> futures;
+    futures.reserve(m_segments.size());
+    for (const auto& segment : m_segments) {
+        futures.push_back(
+            m_pool->submit([&search, &segment]() { return search(segment); }));
+    }
+    for (auto& future : futures) {
+        const auto segment_result = future.get();
+        result.insert(result.end(), segment_result.begin(),
+                      segment_result.end());
+    }
+    return result;
+}
+
+bool ir::QueryProcessor::find_terms(const IndexSegment& segment,
+                                    const std::vector<std::string>& words,
+                                    std::vector<TermInfo>& infos) const {
+    infos.resize(words.size());
+    for (size_t i = 0; i < words.size(); ++i) {
+        if (!segment.dict.find(words[i], infos[i])) {
+            return false;
+        }
+    }
+    return true;
+}
 
 std::vector<size_t> ir::QueryProcessor::conjunctive_query(
     const std::vector<std::string>& words) const {
-
-    // store document IDs of each term
-    std::vector<std::vector<size_t>> posting_lists;
-    for (const auto& word : words) {
-        // if one of the terms doesn't appear at all, return empty set.
-        if (m_dict.find(word) == m_dict.end()) {
+    return search_segments([this, &words](const IndexSegment& segment) {
+        // if one of the terms doesn't appear in the segment, skip it
+        std::vector<TermInfo> infos;
+        if (!find_terms(segment, words, infos)) {
             return std::vector<size_t>();
         }
-        // get term id and docs
-        size_t id = m_dict.at(word);
-        const auto& doc_vec = m_index.at(id);
-
-        // get document IDs containing this term
-        std::vector<size_t> postings(doc_vec.size());
-        std::transform(doc_vec.begin(), doc_vec.end(), postings.begin(),
-                       [](const auto& doc_pair) { return doc_pair.first; });
-
-        // store the document IDs
-        posting_lists.push_back(postings);
-    }
+        return intersect_postings(segment, infos);
+    });
+}
 
+std::vector<size_t>
+ir::QueryProcessor::intersect_postings(const IndexSegment& segment,
+                                       std::vector<TermInfo>& infos) const {
     // return early in trivial cases
-    if (posting_lists.empty()) {
+    if (infos.empty()) {
         return std::vector<size_t>();
-    } else if (posting_lists.size() == 1) {
-        return posting_lists[0];
     }
 
-    // sort the doc_id lists to process the smallest vectors first
-    std::sort(posting_lists.begin(), posting_lists.end(),
-              [](const auto& first, const auto& second) {
-                  return first.size() < second.size();
+    // sort the terms by document frequency to process the smallest lists
+    // first; this doesn't require decoding any of the lists
+    std::sort(infos.begin(), infos.end(),
+              [](const TermInfo& first, const TermInfo& second) {
+                  return first.doc_count < second.doc_count;
               });
 
-    // intersect the first two doc id lists
-    std::vector<size_t> result;
-    intersect(posting_lists[0].begin(), posting_lists[0].end(),
-              posting_lists[1].begin(), posting_lists[1].end(),
-              std::back_inserter(result));
+    // dense lists are intersected with bitmap operations or probed; the
+    // others are intersected by advancing their cursors
+    std::vector<PostingCursor> cursors;
+    std::vector<DocSet> dense_sets;
+    for (const auto& info : infos) {
+        const auto list = segment.index.postings(info);
+        if (list.doc_set().valid()) {
+            dense_sets.push_back(list.doc_set());
+        } else {
+            cursors.emplace_back(list);
+        }
+    }
+    if (cursors.empty()) {
+        return DocSet::intersect(dense_sets);
+    }
 
-    // intersect the cumulative result with the next list
-    std::vector<size_t> tmp;
-    for (size_t i = 2; i < posting_lists.size(); ++i) {
-        intersect(result.begin(), result.end(), posting_lists[i].begin(),
-                  posting_lists[i].end(), std::back_inserter(tmp));
+    // the rarest term proposes candidates and the other cursors skip to them;
+    // whenever a cursor overshoots, the candidate skips ahead instead, so
+    // blocks of the longer lists that cannot contain a result are never
+    // decoded. Candidates are then checked against the dense sets in
+    // constant time.
+    std::vector<size_t> result;
+    auto& lead = cursors[0];
+    while (lead.valid()) {
+        const size_t candidate = lead.doc_id();
+        size_t next_candidate = candidate;
+        for (size_t i = 1; i < cursors.size(); ++i) {
+            cursors[i].advance(candidate);
+            if (!cursors[i].valid()) {
+                return result;
+            } else if (cursors[i].doc_id() != candidate) {
+                next_candidate = cursors[i].doc_id();
+                break;
+            }
+        }
 
-        result = tmp;
-        tmp.clear();
+        if (next_candidate == candidate) {
+            const bool in_dense_sets =
+                std::all_of(dense_sets.begin(), dense_sets.end(),
+                            [candidate](const DocSet& set) {
+                                return set.contains(candidate);
+                            });
+            if (in_dense_sets) {
+                result.push_back(candidate);
+            }
+            lead.next();
+        } else {
+            lead.advance(next_candidate);
+        }
     }
 
     return result;
@@ -81,17 +153,67 @@ std::vector<size_t> ir::QueryProcessor::conjunctive_query(
 std::vector<size_t>
 ir::QueryProcessor::proximity_query(const std::vector<std::string>& words,
                                     const std::vector<size_t>& dists) const {
-    // get the common docs first
-    auto common_docs = this->conjunctive_query(words);
+    return search_segments(
+        [this, &words, &dists](const IndexSegment& segment) {
+            return segment_proximity_query(segment, words, dists);
+        });
+}
 
+std::vector<size_t> ir::QueryProcessor::segment_proximity_query(
+    const IndexSegment& segment, const std::vector<std::string>& words,
+    const std::vector<size_t>& dists) const {
     std::vector<size_t> result;
-    if (common_docs.empty()) {
+
+    // a dropped word, e.g. a stopword, leaves a distance without its word
+    if (words.size() != dists.size() + 1) {
+        return result;
+    }
+
+    // look up the words once; the entries are reused for every document
+    std::vector<TermInfo> infos;
+    if (!find_terms(segment, words, infos)) {
         return result;
     }
 
-    // check if each document contains the proximity query
+    // adjacent words with an indexed bigram are intersected through the list
+    // of the bigram instead of their own lists
+    std::vector<TermInfo> candidate_infos;
+    std::vector<bool> in_bigram(words.size(), false);
+    for (size_t i = 0; i < dists.size(); ++i) {
+        if (dists[i] != 0 ||
+            !is_indexed_bigram(m_common_terms, words[i], words[i + 1])) {
+            continue;
+        }
+        // an indexed bigram missing from the segment never occurs in it
+        TermInfo info;
+        if (!segment.dict.find(bigram_key(words[i], words[i + 1]), info)) {
+            return result;
+        }
+        candidate_infos.push_back(info);
+        in_bigram[i] = in_bigram[i + 1] = true;
+    }
+    for (size_t i = 0; i < words.size(); ++i) {
+        if (!in_bigram[i]) {
+            candidate_infos.push_back(infos[i]);
+        }
+    }
+
+    // get the common docs first
+    auto common_docs = intersect_postings(segment, candidate_infos);
+    if (common_docs.empty() || (words.size() == 2 && in_bigram[0])) {
+        return common_docs;
+    }
+
+    // check if each document contains the proximity query; documents are
+    // visited in increasing order, so a single cursor per word suffices. The
+    // cursors skip to the candidates, so the long lists of the common words
+    // of a bigram are only decoded at the blocks holding candidates
+    std::vector<PostingCursor> cursors;
+    for (const auto& info : infos) {
+        cursors.emplace_back(segment.index.postings(info));
+    }
     for (const size_t doc_id : common_docs) {
-        if (contains_proximity_query(doc_id, words, dists)) {
+        if (contains_proximity_query(doc_id, cursors, dists)) {
             result.push_back(doc_id);
         }
     }
@@ -100,18 +222,16 @@ ir::QueryProcessor::proximity_query(const std::vector<std::string>& words,
 }
 
 bool ir::QueryProcessor::contains_proximity_query(
-    size_t doc_id, const std::vector<std::string>& words,
+    size_t doc_id, std::vector<PostingCursor>& cursors,
     const std::vector<size_t>& dists) const {
 
-    // store the position vector of each word in the current doc with id doc_id
-    std::vector<std::vector<size_t>> word_pos;
-    for (const auto& word : words) {
-        size_t word_id = m_dict.at(word);
-        for (const auto& doc_pair : m_index.at(word_id)) {
-            if (doc_pair.first == doc_id) {
-                word_pos.push_back(doc_pair.second);
-                break;
-            }
+    // decode the position vector of each word in the current doc with id
+    // doc_id
+    std::vector<std::vector<uint32_t>> word_pos;
+    for (auto& cursor : cursors) {
+        cursor.advance(doc_id);
+        if (cursor.valid() && cursor.doc_id() == doc_id) {
+            word_pos.push_back(cursor.positions());
         }
     }
 
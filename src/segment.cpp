@@ -0,0 +1,230 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "segment.hpp"
+#include "dictionary.hpp"
+#include "file_manager.hpp"
+#include "index_writer.hpp"
+#include "posting_list.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <utility>
+
+/**
+ * @brief Return the tier of a segment with the given number of documents.
+ */
+static size_t tier_of(size_t doc_count) {
+    size_t tier = 0;
+    for (; doc_count >= ir::MERGE_FACTOR; doc_count /= ir::MERGE_FACTOR) {
+        ++tier;
+    }
+    return tier;
+}
+
+void ir::merge_segments(const std::vector<std::string>& dirs,
+                        const std::string& out_dir) {
+    ShardedIndexWriter writer({out_dir}, {});
+    merge_segments(dirs, writer);
+}
+
+void ir::merge_segments(const std::vector<std::string>& dirs,
+                        ShardedIndexWriter& writer) {
+    std::vector<Dictionary> dicts;
+    std::vector<IndexReader> indices;
+    for (const auto& dir : dirs) {
+        dicts.push_back(read_dict_file(dir));
+        indices.push_back(read_index_file(dir));
+    }
+    // cursors point to the dictionaries, which must not move anymore
+    std::vector<DictionaryCursor> cursors;
+    for (const auto& dict : dicts) {
+        cursors.push_back(dict.begin());
+    }
+
+    std::vector<std::pair<size_t, std::vector<size_t>>> doc_vec;
+    std::string term;
+    while (true) {
+        // the smallest term of all the segments is written next
+        bool found = false;
+        for (const auto& cursor : cursors) {
+            if (cursor.valid() && (!found || cursor.term() < term)) {
+                term = cursor.term();
+                found = true;
+            }
+        }
+        if (!found) {
+            break;
+        }
+
+        // gather the postings of the term from each segment containing it
+        doc_vec.clear();
+        for (size_t i = 0; i < cursors.size(); ++i) {
+            auto& cursor = cursors[i];
+            if (!cursor.valid() || cursor.term() != term) {
+                continue;
+            }
+            for (PostingCursor postings(indices[i].postings(cursor.info()));
+                 postings.valid(); postings.next()) {
+                const auto& positions = postings.positions();
+                doc_vec.emplace_back(
+                    postings.doc_id(),
+                    std::vector<size_t>(positions.begin(), positions.end()));
+            }
+            cursor.next();
+        }
+
+        // segments hold disjoint documents, but not necessarily in order
+        std::sort(doc_vec.begin(), doc_vec.end(),
+                  [](const auto& left, const auto& right) {
+                      return left.first < right.first;
+                  });
+        writer.add(term, doc_vec);
+    }
+    writer.finish();
+}
+
+ir::SegmentMerger::SegmentMerger(Manifest manifest)
+    : m_manifest(std::move(manifest)) {
+    if (mkdir(INDEX_DIR.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Could not create " + INDEX_DIR);
+    }
+    m_thread = std::thread(&SegmentMerger::run, this);
+}
+
+ir::SegmentMerger::~SegmentMerger() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done = true;
+        }
+        m_cond.notify_one();
+        m_thread.join();
+    }
+}
+
+std::string ir::SegmentMerger::new_segment() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::ostringstream name;
+    name << "seg_" << std::setw(6) << std::setfill('0') << m_manifest.next_id++;
+    return name.str();
+}
+
+void ir::SegmentMerger::commit(const std::vector<SegmentInfo>& segments,
+                               const std::vector<std::string>& files,
+                               const std::vector<std::string>& common_terms) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_manifest.common_terms = common_terms;
+        m_manifest.segments.insert(m_manifest.segments.end(), segments.begin(),
+                                   segments.end());
+        m_manifest.files.insert(m_manifest.files.end(), files.begin(),
+                                files.end());
+        write_manifest(m_manifest);
+    }
+    m_cond.notify_one();
+}
+
+void ir::SegmentMerger::finish() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_done = true;
+    }
+    m_cond.notify_one();
+    m_thread.join();
+
+    if (!m_error.empty()) {
+        throw std::runtime_error(m_error);
+    }
+}
+
+std::vector<size_t> ir::SegmentMerger::select_merge() const {
+    const auto& segments = m_manifest.segments;
+
+    // group the segments by shard and tier and merge the oldest segments of
+    // the first group that has enough segments
+    std::map<std::pair<size_t, size_t>, std::vector<size_t>> groups;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        auto& group =
+            groups[{segments[i].shard, tier_of(segments[i].doc_count)}];
+        group.push_back(i);
+        if (group.size() == MERGE_FACTOR) {
+            return group;
+        }
+    }
+    return std::vector<size_t>();
+}
+
+void ir::SegmentMerger::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        const auto selected = select_merge();
+        if (selected.empty()) {
+            if (m_done) {
+                return;
+            }
+            m_cond.wait(lock);
+            continue;
+        }
+
+        std::vector<std::string> dirs;
+        std::vector<std::string> names;
+        SegmentInfo merged{"", 0, m_manifest.segments[selected[0]].shard};
+        for (size_t i : selected) {
+            const auto& segment = m_manifest.segments[i];
+            names.push_back(segment.name);
+            dirs.push_back(segment_dir(segment.name));
+            merged.doc_count += segment.doc_count;
+        }
+        lock.unlock();
+        merged.name = new_segment();
+
+        // segments are immutable, so they are merged without holding the lock
+        try {
+            merge_segments(dirs, segment_dir(merged.name));
+        } catch (const std::runtime_error& e) {
+            remove_segment(segment_dir(merged.name));
+            lock.lock();
+            m_error = e.what();
+            return;
+        }
+
+        // replace the merged segments in the manifest before deleting them
+        lock.lock();
+        auto is_merged = [&names](const SegmentInfo& segment) {
+            return std::find(names.begin(), names.end(), segment.name) !=
+                   names.end();
+        };
+        auto& segments = m_manifest.segments;
+        segments.erase(
+            std::remove_if(segments.begin(), segments.end(), is_merged),
+            segments.end());
+        segments.push_back(merged);
+        try {
+            write_manifest(m_manifest);
+        } catch (const std::runtime_error& e) {
+            m_error = e.what();
+            return;
+        }
+        for (const auto& dir : dirs) {
+            remove_segment(dir);
+        }
+    }
+}
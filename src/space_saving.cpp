@@ -0,0 +1,188 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "space_saving.hpp"
+#include "hash.hpp"
+#include <algorithm>
+
+/**
+ * @brief Return the smallest power of two that is at least twice the given
+ * capacity, so that the table is at most half full.
+ */
+static size_t slot_count_of(size_t capacity) {
+    size_t slot_count = 1;
+    while (slot_count < 2 * capacity) {
+        slot_count *= 2;
+    }
+    return slot_count;
+}
+
+ir::SpaceSaving::SpaceSaving(size_t capacity)
+    : m_capacity(std::min<size_t>(capacity, None)) {}
+
+void ir::SpaceSaving::add(std::string_view item, size_t count) {
+    if (m_capacity == 0 || count == 0) {
+        return;
+    }
+    if (m_slots.empty()) {
+        m_slots.assign(slot_count_of(m_capacity), None);
+    }
+
+    const uint64_t hash = hash_bytes(item.data(), item.size());
+    const size_t slot = find_slot(item, hash);
+    uint32_t index = m_slots[slot];
+    if (index != None) {
+        const size_t old_count = m_buckets[m_counters[index].bucket].count;
+        link(index, old_count + count, unlink(index));
+        return;
+    }
+
+    if (m_counters.size() < m_capacity) {
+        index = static_cast<uint32_t>(m_counters.size());
+        m_counters.push_back({std::string(item), hash, None, None, None});
+        m_slots[slot] = index;
+        link(index, count, None);
+        return;
+    }
+
+    // replace an item with the smallest counter, which is in the first bucket
+    index = m_buckets[m_first_bucket].first;
+    auto& counter = m_counters[index];
+    const size_t min_count = m_buckets[m_first_bucket].count;
+    erase_slot(find_slot(counter.item, counter.hash));
+    counter.item.assign(item.data(), item.size());
+    counter.hash = hash;
+    // erasing may have moved the slots after the erased one
+    m_slots[find_slot(item, hash)] = index;
+    link(index, min_count + count, unlink(index));
+}
+
+void ir::SpaceSaving::merge(const SpaceSaving& other) {
+    for (const auto& counter : other.m_counters) {
+        add(counter.item, other.m_buckets[counter.bucket].count);
+    }
+}
+
+std::vector<std::pair<std::string, size_t>>
+ir::SpaceSaving::top(size_t k) const {
+    std::vector<std::pair<std::string, size_t>> result;
+    for (const auto& counter : m_counters) {
+        result.emplace_back(counter.item, m_buckets[counter.bucket].count);
+    }
+    k = std::min(k, result.size());
+    // ties are broken by item to make the result deterministic
+    std::partial_sort(result.begin(), result.begin() + k, result.end(),
+                      [](const auto& left, const auto& right) {
+                          return left.second != right.second
+                                     ? left.second > right.second
+                                     : left.first < right.first;
+                      });
+    result.resize(k);
+    return result;
+}
+
+size_t ir::SpaceSaving::find_slot(std::string_view item, uint64_t hash) const {
+    const size_t mask = m_slots.size() - 1;
+    // the table always has free slots, so probing terminates
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const uint32_t index = m_slots[i];
+        if (index == None || (m_counters[index].hash == hash &&
+                              m_counters[index].item == item)) {
+            return i;
+        }
+    }
+}
+
+void ir::SpaceSaving::erase_slot(size_t slot) {
+    // shift the following counters back so that no probe sequence passes
+    // through a free slot; a counter can fill the hole if the hole is between
+    // its home slot and its current slot
+    const size_t mask = m_slots.size() - 1;
+    for (size_t i = (slot + 1) & mask; m_slots[i] != None; i = (i + 1) & mask) {
+        const size_t home = m_counters[m_slots[i]].hash & mask;
+        if (((i - home) & mask) >= ((i - slot) & mask)) {
+            m_slots[slot] = m_slots[i];
+            slot = i;
+        }
+    }
+    m_slots[slot] = None;
+}
+
+void ir::SpaceSaving::link(uint32_t index, size_t count, uint32_t after) {
+    uint32_t next = after == None ? m_first_bucket : m_buckets[after].next;
+    while (next != None && m_buckets[next].count < count) {
+        after = next;
+        next = m_buckets[next].next;
+    }
+
+    uint32_t bucket = next;
+    if (next == None || m_buckets[next].count != count) {
+        const Bucket new_bucket = {count, None, after, next};
+        if (m_free_buckets.empty()) {
+            bucket = static_cast<uint32_t>(m_buckets.size());
+            m_buckets.push_back(new_bucket);
+        } else {
+            bucket = m_free_buckets.back();
+            m_free_buckets.pop_back();
+            m_buckets[bucket] = new_bucket;
+        }
+        if (after == None) {
+            m_first_bucket = bucket;
+        } else {
+            m_buckets[after].next = bucket;
+        }
+        if (next != None) {
+            m_buckets[next].prev = bucket;
+        }
+    }
+
+    auto& counter = m_counters[index];
+    counter.bucket = bucket;
+    counter.prev = None;
+    counter.next = m_buckets[bucket].first;
+    if (counter.next != None) {
+        m_counters[counter.next].prev = index;
+    }
+    m_buckets[bucket].first = index;
+}
+
+uint32_t ir::SpaceSaving::unlink(uint32_t index) {
+    const auto& counter = m_counters[index];
+    const uint32_t bucket_index = counter.bucket;
+    auto& bucket = m_buckets[bucket_index];
+    if (counter.prev == None) {
+        bucket.first = counter.next;
+    } else {
+        m_counters[counter.prev].next = counter.next;
+    }
+    if (counter.next != None) {
+        m_counters[counter.next].prev = counter.prev;
+    }
+    if (bucket.first != None) {
+        return bucket_index;
+    }
+
+    if (bucket.prev == None) {
+        m_first_bucket = bucket.next;
+    } else {
+        m_buckets[bucket.prev].next = bucket.next;
+    }
+    if (bucket.next != None) {
+        m_buckets[bucket.next].prev = bucket.prev;
+    }
+    m_free_buckets.push_back(bucket_index);
+    return bucket.prev;
+}
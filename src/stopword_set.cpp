@@ -0,0 +1,71 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stopword_set.hpp"
+#include "hash.hpp"
+#include <algorithm>
+#include <utility>
+
+/**
+ * @brief Number of seeds tried for a table size before the table is doubled.
+ */
+static constexpr uint64_t SEEDS_PER_SIZE = 64;
+
+ir::StopwordSet::StopwordSet(std::vector<std::string> words)
+    : m_words(std::move(words)) {
+    std::sort(m_words.begin(), m_words.end());
+    m_words.erase(std::unique(m_words.begin(), m_words.end()), m_words.end());
+    if (m_words.empty()) {
+        return;
+    }
+
+    // start from a table at most 1/8 full; a table with more than n^2 slots
+    // for n words is collision free for most seeds, so the search ends soon
+    size_t slot_count = 1;
+    while (slot_count < 8 * m_words.size()) {
+        slot_count *= 2;
+    }
+    for (uint64_t seed = 0; !place_words(slot_count, seed); ++seed) {
+        if (seed % SEEDS_PER_SIZE == SEEDS_PER_SIZE - 1) {
+            slot_count *= 2;
+        }
+    }
+}
+
+bool ir::StopwordSet::place_words(size_t slot_count, uint64_t seed) {
+    m_slots.assign(slot_count, 0);
+    m_seed = seed;
+    const size_t mask = slot_count - 1;
+    for (size_t i = 0; i < m_words.size(); ++i) {
+        const auto& word = m_words[i];
+        auto& slot = m_slots[hash_bytes(word.data(), word.size(), seed) & mask];
+        if (slot != 0) {
+            return false;
+        }
+        slot = static_cast<uint32_t>(i + 1);
+    }
+    return true;
+}
+
+bool ir::StopwordSet::contains(std::string_view word) const {
+    if (m_slots.empty()) {
+        return false;
+    }
+    const size_t mask = m_slots.size() - 1;
+    const uint32_t slot =
+        m_slots[hash_bytes(word.data(), word.size(), m_seed) & mask];
+    return slot != 0 && m_words[slot - 1] == word;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tag_scanner.hpp"
+#include "block_codec.hpp"
+#include <cassert>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define IR_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+size_t ir::find_tag_open_scalar(std::string_view text, size_t pos) {
+    if (pos >= text.size()) {
+        return std::string_view::npos;
+    }
+    const auto* match = static_cast<const char*>(
+        std::memchr(text.data() + pos, '<', text.size() - pos));
+    return match ? static_cast<size_t>(match - text.data())
+                 : std::string_view::npos;
+}
+
+#ifdef IR_X86_SIMD
+__attribute__((target("sse2"))) size_t
+ir::find_tag_open_sse2(std::string_view text, size_t pos) {
+    const __m128i open = _mm_set1_epi8('<');
+    for (; pos + 16 <= text.size(); pos += 16) {
+        const __m128i chunk = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(text.data() + pos));
+        const auto mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, open)));
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+    // less than a register of characters is left
+    return find_tag_open_scalar(text, pos);
+}
+
+__attribute__((target("avx2"))) size_t
+ir::find_tag_open_avx2(std::string_view text, size_t pos) {
+    const __m256i open = _mm256_set1_epi8('<');
+    for (; pos + 32 <= text.size(); pos += 32) {
+        const __m256i chunk = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(text.data() + pos));
+        const auto mask = static_cast<unsigned>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, open)));
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+    return find_tag_open_sse2(text, pos);
+}
+#else
+size_t ir::find_tag_open_sse2(std::string_view text, size_t pos) {
+    return find_tag_open_scalar(text, pos);
+}
+
+size_t ir::find_tag_open_avx2(std::string_view text, size_t pos) {
+    return find_tag_open_scalar(text, pos);
+}
+#endif
+
+size_t ir::find_tag_open(std::string_view text, size_t pos) {
+    switch (simd_level()) {
+    case SimdLevel::AVX2:
+        return find_tag_open_avx2(text, pos);
+    case SimdLevel::SSE41:
+        return find_tag_open_sse2(text, pos);
+    default:
+        return find_tag_open_scalar(text, pos);
+    }
+}
+
+size_t ir::find_tag(std::string_view text, std::string_view tag, size_t pos) {
+    assert(!tag.empty() && tag[0] == '<');
+    for (pos = find_tag_open(text, pos); pos != std::string_view::npos;
+         pos = find_tag_open(text, pos + 1)) {
+        if (tag_at(text, pos, tag)) {
+            return pos;
+        }
+    }
+    return std::string_view::npos;
+}
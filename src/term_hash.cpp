@@ -0,0 +1,283 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "term_hash.hpp"
+#include "file_manager.hpp"
+#include "hash.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+static_assert(sizeof(ir::TermHashSlot) == 40,
+              "TermHashSlot must have the same size on every platform");
+
+/**
+ * @brief Return the bucket of a term with the given hash.
+ */
+static size_t bucket_of(uint64_t hash, size_t bucket_count) {
+    return hash % bucket_count;
+}
+
+/**
+ * @brief Return the values f and g of a term with the given hash.
+ */
+static std::pair<uint64_t, uint64_t> fg_of(uint64_t hash, size_t term_count) {
+    return {(hash >> 32) % term_count, ir::mix64(hash) % term_count};
+}
+
+/**
+ * @brief Return the slot of a term with the given hash when its bucket has the
+ * given displacement.
+ *
+ * The displacement encodes the pair \f$(d_0, d_1)\f$ as \f$d_0 n + d_1\f$.
+ */
+static size_t slot_of(std::pair<uint64_t, uint64_t> fg, uint32_t displacement,
+                      size_t term_count) {
+    const uint64_t d0 = displacement / term_count;
+    const uint64_t d1 = displacement % term_count;
+    return (fg.first + d0 * fg.second + d1) % term_count;
+}
+
+/**
+ * @brief Try to find a displacement for each bucket so that the terms with
+ * the given hashes are placed into distinct slots.
+ *
+ * @param hashes Hash of each term.
+ * @param bucket_count Number of buckets.
+ * @param displacements Output vector of the displacement of each bucket.
+ * @param slot_terms Output vector of the index of the term placed in each
+ * slot.
+ *
+ * @return true if a displacement is found for every bucket; false if a
+ * different seed must be used, e.g. because two terms of a bucket have the
+ * same f and g, which no displacement can separate.
+ */
+static bool place_terms(const std::vector<uint64_t>& hashes,
+                        size_t bucket_count,
+                        std::vector<uint32_t>& displacements,
+                        std::vector<size_t>& slot_terms) {
+    const size_t term_count = hashes.size();
+    std::vector<std::vector<size_t>> buckets(bucket_count);
+    for (size_t i = 0; i < term_count; ++i) {
+        buckets[bucket_of(hashes[i], bucket_count)].push_back(i);
+    }
+
+    // f and g of each term are computed once and reused for every
+    // displacement tried
+    std::vector<std::pair<uint64_t, uint64_t>> term_fgs(term_count);
+    for (size_t i = 0; i < term_count; ++i) {
+        term_fgs[i] = fg_of(hashes[i], term_count);
+    }
+
+    std::vector<std::pair<uint64_t, uint64_t>> fgs;
+    for (const auto& terms : buckets) {
+        fgs.clear();
+        for (size_t term : terms) {
+            fgs.push_back(term_fgs[term]);
+        }
+        std::sort(fgs.begin(), fgs.end());
+        if (std::adjacent_find(fgs.begin(), fgs.end()) != fgs.end()) {
+            return false;
+        }
+    }
+
+    // place the largest buckets first while most of the slots are free
+    std::vector<size_t> order(bucket_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&buckets](size_t a, size_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    const size_t free_slot = std::numeric_limits<size_t>::max();
+    displacements.assign(bucket_count, 0);
+    slot_terms.assign(term_count, free_slot);
+
+    // displacements d0 n + d1 with d0, d1 < n are all the distinct ones; if
+    // none of them fits a bucket, the remaining free slots cannot hold it
+    const uint64_t max_displacement =
+        std::min<uint64_t>(static_cast<uint64_t>(term_count) * term_count,
+                           std::numeric_limits<uint32_t>::max());
+
+    std::vector<size_t> slots;
+    for (size_t bucket : order) {
+        const auto& terms = buckets[bucket];
+        if (terms.empty()) {
+            break;
+        }
+
+        uint32_t displacement = 0;
+        for (;; ++displacement) {
+            if (displacement == max_displacement) {
+                return false;
+            }
+
+            slots.clear();
+            bool fits = true;
+            for (size_t term : terms) {
+                const size_t slot =
+                    slot_of(term_fgs[term], displacement, term_count);
+                if (slot_terms[slot] != free_slot ||
+                    std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                    fits = false;
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if (fits) {
+                break;
+            }
+        }
+
+        displacements[bucket] = displacement;
+        for (size_t i = 0; i < terms.size(); ++i) {
+            slot_terms[slots[i]] = terms[i];
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Append the given integer to out as 8 little endian bytes.
+ */
+static void append_u64(uint64_t value, std::vector<uint8_t>& out) {
+    for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void ir::encode_term_hash(const std::vector<std::string>& terms,
+                          const std::vector<TermInfo>& term_infos,
+                          std::vector<uint8_t>& out) {
+    assert(terms.size() == term_infos.size());
+    const size_t term_count = terms.size();
+    const size_t bucket_count =
+        (term_count + TERM_HASH_BUCKET_SIZE - 1) / TERM_HASH_BUCKET_SIZE;
+
+    // try new seeds until the terms can be placed
+    uint64_t seed = 0;
+    std::vector<uint64_t> hashes(term_count);
+    std::vector<uint32_t> displacements;
+    std::vector<size_t> slot_terms;
+    for (;; ++seed) {
+        for (size_t i = 0; i < term_count; ++i) {
+            hashes[i] = hash_bytes(terms[i].data(), terms[i].size(), seed);
+        }
+        if (place_terms(hashes, bucket_count, displacements, slot_terms)) {
+            break;
+        }
+    }
+
+    append_u64(term_count, out);
+    append_u64(bucket_count, out);
+    append_u64(seed, out);
+
+    // displacements are padded so that the slots are aligned
+    const size_t disp_size = displacements.size() * sizeof(uint32_t);
+    const size_t disp_begin = out.size();
+    out.resize(disp_begin + (disp_size + 7) / 8 * 8, 0);
+    std::copy_n(reinterpret_cast<const uint8_t*>(displacements.data()),
+                disp_size, out.begin() + disp_begin);
+
+    std::vector<TermHashSlot> slots(term_count);
+    std::string all_terms;
+    for (size_t slot = 0; slot < term_count; ++slot) {
+        const size_t term = slot_terms[slot];
+        const auto& info = term_infos[term];
+        slots[slot] = {info.offset,
+                       info.pos_offset,
+                       static_cast<uint32_t>(info.length),
+                       static_cast<uint32_t>(info.pos_length),
+                       static_cast<uint32_t>(info.doc_count),
+                       static_cast<uint32_t>(info.id),
+                       static_cast<uint32_t>(all_terms.size()),
+                       static_cast<uint32_t>(terms[term].size())};
+        all_terms += terms[term];
+    }
+
+    const auto* slot_bytes = reinterpret_cast<const uint8_t*>(slots.data());
+    out.insert(out.end(), slot_bytes,
+               slot_bytes + slots.size() * sizeof(TermHashSlot));
+    out.insert(out.end(), all_terms.begin(), all_terms.end());
+}
+
+ir::TermHash::TermHash(const std::string& path)
+    : m_file(path, MappedFile::AccessPattern::Random) {
+    const size_t header_size = TERM_HASH_MAGIC.size() + 3 * sizeof(uint64_t);
+    if (m_file.size() < header_size ||
+        std::memcmp(m_file.data(), TERM_HASH_MAGIC.data(),
+                    TERM_HASH_MAGIC.size()) != 0) {
+        throw std::runtime_error(path + " is not a valid term hash file!");
+    }
+
+    const char* header = m_file.data() + TERM_HASH_MAGIC.size();
+    uint64_t term_count, bucket_count;
+    std::memcpy(&term_count, header, sizeof(uint64_t));
+    std::memcpy(&bucket_count, header + sizeof(uint64_t), sizeof(uint64_t));
+    std::memcpy(&m_seed, header + 2 * sizeof(uint64_t), sizeof(uint64_t));
+
+    const size_t disp_size = (bucket_count * sizeof(uint32_t) + 7) / 8 * 8;
+    const size_t terms_begin =
+        header_size + disp_size + term_count * sizeof(TermHashSlot);
+    if (bucket_count != (term_count + TERM_HASH_BUCKET_SIZE - 1) /
+                            TERM_HASH_BUCKET_SIZE ||
+        m_file.size() < terms_begin) {
+        throw std::runtime_error(path + " is not a valid term hash file!");
+    }
+
+    m_term_count = term_count;
+    m_bucket_count = bucket_count;
+    // the magic is a multiple of 8 bytes long, so the tables are aligned
+    m_displacements =
+        reinterpret_cast<const uint32_t*>(m_file.data() + header_size);
+    m_slots = reinterpret_cast<const TermHashSlot*>(m_file.data() +
+                                                    header_size + disp_size);
+    m_terms = m_file.data() + terms_begin;
+}
+
+bool ir::TermHash::find(const std::string& term, TermInfo& info) const {
+    if (m_term_count == 0) {
+        return false;
+    }
+
+    const uint64_t hash = hash_bytes(term.data(), term.size(), m_seed);
+    const uint32_t displacement =
+        m_displacements[bucket_of(hash, m_bucket_count)];
+    const auto& slot =
+        m_slots[slot_of(fg_of(hash, m_term_count), displacement, m_term_count)];
+
+    // every string hashes to some slot; verify the term stored in it
+    if (slot.term_length != term.size() ||
+        std::memcmp(m_terms + slot.term_offset, term.data(), term.size()) != 0) {
+        return false;
+    }
+
+    info = {slot.id,     slot.doc_count,  slot.offset,
+            slot.length, slot.pos_offset, slot.pos_length};
+    return true;
+}
+
+ir::TermInfo ir::TermHash::at(const std::string& term) const {
+    TermInfo info;
+    if (!find(term, info)) {
+        throw std::out_of_range(term + " does not exist in the term hash");
+    }
+    return info;
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "term_pool.hpp"
+#include <mutex>
+#include <stdexcept>
+
+uint32_t ir::TermPool::intern(std::string_view term) {
+    {
+        // most terms are already in the pool
+        std::shared_lock<std::shared_timed_mutex> lock(m_mutex);
+        const auto it = m_ids.find(term);
+        if (it != m_ids.end()) {
+            return it->second;
+        }
+    }
+
+    std::lock_guard<std::shared_timed_mutex> lock(m_mutex);
+    // another thread may have added the term in the meantime
+    const auto it = m_ids.find(term);
+    if (it != m_ids.end()) {
+        return it->second;
+    }
+    if (m_terms.size() == NO_TERM_ID) {
+        throw std::runtime_error("Too many distinct terms");
+    }
+
+    const auto id = static_cast<uint32_t>(m_terms.size());
+    m_terms.emplace_back(term);
+    m_ids.emplace(m_terms.back(), id);
+    return id;
+}
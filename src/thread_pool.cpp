@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018 Esref Ozdemir
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "thread_pool.hpp"
+#include <algorithm>
+
+/**
+ * @brief Pool and index of the worker running on the calling thread; null if
+ * the thread is not a worker.
+ */
+static thread_local const ir::ThreadPool* current_pool = nullptr;
+static thread_local size_t current_index = 0;
+
+ir::ThreadPool::ThreadPool(size_t thread_count) {
+    thread_count = std::max<size_t>(thread_count, 1);
+    for (size_t i = 0; i < thread_count; ++i) {
+        m_deques.push_back(std::make_unique<TaskDeque>());
+    }
+    // deques must exist before any worker can steal from them
+    m_threads.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        m_threads.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ir::ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+size_t ir::ThreadPool::worker_index() const {
+    return current_pool == this ? current_index : m_threads.size();
+}
+
+void ir::ThreadPool::push(std::function<void()> task) {
+    size_t index = worker_index();
+    if (index == m_deques.size()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        index = m_next_deque;
+        m_next_deque = (m_next_deque + 1) % m_deques.size();
+    }
+    {
+        auto& deque = *m_deques[index];
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        deque.tasks.push_back(std::move(task));
+    }
+    // the task is counted only after it can be found in its deque
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_pending;
+    }
+    m_cond.notify_one();
+}
+
+bool ir::ThreadPool::pop(size_t index, std::function<void()>& task) {
+    {
+        auto& own = *m_deques[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < m_deques.size(); ++i) {
+        auto& victim = *m_deques[(index + i) % m_deques.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ir::ThreadPool::run(size_t index) {
+    current_pool = this;
+    current_index = index;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]() { return m_stop || m_pending > 0; });
+            if (m_pending == 0) {
+                // stopped and nothing left to run
+                return;
+            }
+            // claim one of the pending tasks
+            --m_pending;
+        }
+
+        // every claim is backed by a task in some deque, so the search
+        // succeeds, possibly after another worker takes a different task
+        std::function<void()> task;
+        while (!pop(index, task)) {
+            std::this_thread::yield();
+        }
+        task();
+    }
+}
@@ -15,30 +15,84 @@
  */
 
 #include "tokenizer.hpp"
-#include "util.hpp"
+#include "char_class.hpp"
+#include "stopword_set.hpp"
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstring>
 #include <file_manager.hpp>
 #include <fstream>
 #include <iostream>
 #include <numeric>
+#include <utility>
 
-// tell the compiler that stem will be externally linked
-extern int stem(char* p, int i, int j);
+/**
+ * @brief Return the next whitespace separated token of the given text
+ * starting at pos and move pos past the token.
+ *
+ * @return The token; an empty view if there are no tokens left.
+ */
+static std::string_view next_token(std::string_view text, size_t& pos) {
+    const size_t beg = ir::skip_delimiters(text, pos);
+    pos = ir::find_delimiter(text, beg);
+    return text.substr(beg, pos - beg);
+}
+
+/**
+ * @brief Remove punctuation from the given token in place as specified in
+ * ir::normalize.
+ */
+static void remove_punctuation_in_place(std::string& token) {
+    // remove certain puncts from anywhere in the word
+    auto is_stripped = [](const char c) {
+        return ir::is_char_class(c, ir::CHAR_STRIPPED);
+    };
+    token.erase(std::remove_if(token.begin(), token.end(), is_stripped),
+                token.end());
+
+    // remove any kind of punct from the start and end of the word; a token
+    // made of punctuation only must not be scanned past either end
+    size_t end = token.size();
+    while (end > 0 && !ir::is_alnum(token[end - 1])) {
+        --end;
+    }
+    size_t beg = 0;
+    while (beg < end && !ir::is_alnum(token[beg])) {
+        ++beg;
+    }
+    token.erase(end);
+    token.erase(0, beg);
+}
 
 ir::Tokenizer::Stats::Stats()
     : total_unnormalized_tokens(0), total_normalized_tokens(0),
-      total_unnormalized_terms(0), total_normalized_terms(0) {}
+      total_unnormalized_terms(0), total_normalized_terms(0),
+      mode(StatsMode::Exact), cache_hits(0), cache_misses(0) {}
+
+ir::Tokenizer::Tokenizer(size_t cache_capacity,
+                         const StatsOptions& stats_options,
+                         TermPool* term_pool)
+    : m_stats_options(stats_options), m_term_pool(term_pool),
+      m_cache(cache_capacity) {
+    m_stats.mode = stats_options.mode;
+    if (stats_options.mode == StatsMode::Approximate) {
+        for (auto* term_stats : {&unnormalized_terms, &normalized_terms}) {
+            term_stats->top_terms =
+                SpaceSaving(stats_options.top_term_capacity);
+            term_stats->term_count =
+                HyperLogLog(stats_options.term_count_precision);
+        }
+    }
+}
 
 std::vector<std::pair<std::string, size_t>>
 ir::Tokenizer::tokenize(const std::string& str) {
-    std::string str_copy(str);
-    auto tokens = split(str_copy, " \t\n\r\v\f");
-
     std::vector<std::pair<std::string, size_t>> result;
-    for (size_t i = 0; i < tokens.size(); ++i) {
-        result.emplace_back(tokens[i], i);
+    size_t pos = 0;
+    for (auto token = next_token(str, pos); !token.empty();
+         token = next_token(str, pos)) {
+        result.emplace_back(token, result.size());
     }
     m_stats.total_unnormalized_tokens += result.size();
 
@@ -47,65 +101,69 @@ ir::Tokenizer::tokenize(const std::string& str) {
 
 std::string ir::Tokenizer::remove_punctuation(const std::string& token) {
     std::string result(token);
-
-    // remove certain puncts from anywhere in the word
-    std::replace(result.begin(), result.end(), '\"', '\'');
-    std::replace(result.begin(), result.end(), ',', '\'');
-    std::replace(result.begin(), result.end(), '<', '\'');
-    std::replace(result.begin(), result.end(), '>', '\'');
-    result.erase(std::remove(result.begin(), result.end(), '\''), result.end());
-
-    if (result.empty()) {
-        return result;
-    }
-
-    // iterate as long as current char is not alphanumeric and not '
-    // (' will be removed)
-    auto to_remove = [](const char c) { return c != '\'' && !isalnum(c); };
-    // remove any kind of punct from the start and end of the word
-    for (size_t i = 0; to_remove(result[i]); ++i) {
-        result[i] = '\'';
-    }
-    for (size_t i = result.size() - 1; to_remove(result[i]); --i) {
-        result[i] = '\'';
-    }
-    result.erase(std::remove(result.begin(), result.end(), '\''), result.end());
-
+    remove_punctuation_in_place(result);
     return result;
 }
 
-bool ir::Tokenizer::is_stopword(const std::string& word) {
-    static std::vector<std::string> stopwords;
-
-    // if calling for the first time
-    if (stopwords.empty()) {
+bool ir::Tokenizer::is_stopword(std::string_view word) {
+    // the list is read when the function is called for the first time; the
+    // initialization of a static local is thread safe, and the set is never
+    // modified afterwards
+    static const StopwordSet stopwords = []() {
+        std::vector<std::string> words;
         std::ifstream ifs(ir::STOPWORD_PATH);
         std::string stopword;
         while (ifs >> stopword) {
-            stopwords.push_back(stopword);
+            words.push_back(stopword);
         }
-        assert(!stopwords.empty());
+        assert(!words.empty());
 
-        std::sort(stopwords.begin(), stopwords.end());
-    }
+        return StopwordSet(std::move(words));
+    }();
 
-    return std::binary_search(stopwords.begin(), stopwords.end(), word);
+    return stopwords.contains(word);
 }
 
 std::string ir::Tokenizer::normalize(const std::string& token) {
+    uint32_t term_id;
+    return std::string(normalize_view(token, term_id));
+}
+
+std::string_view ir::Tokenizer::normalize_view(std::string_view token,
+                                               uint32_t& term_id) {
+    if (m_cache.enabled()) {
+        if (const auto* entry = m_cache.find(token)) {
+            ++m_stats.cache_hits;
+            term_id = entry->term_id;
+            return entry->term;
+        }
+        ++m_stats.cache_misses;
+    }
+
+    normalize_uncached(token);
+    term_id = NO_TERM_ID;
+    if (m_term_pool != nullptr && !m_term.empty()) {
+        term_id = m_term_pool->intern(m_term);
+    }
+    if (m_cache.enabled()) {
+        m_cache.insert(token, m_term, term_id);
+    }
+    return m_term;
+}
+
+void ir::Tokenizer::normalize_uncached(std::string_view token) {
     // remove punctuation using heuristics
-    std::string result = remove_punctuation(token);
+    m_term.assign(token.data(), token.size());
+    remove_punctuation_in_place(m_term);
     // convert string to lowercase
-    std::transform(result.begin(), result.end(), result.begin(), tolower);
+    ir::to_lower(&m_term[0], m_term.size());
     // if string is a stopword, return empty string
-    if (is_stopword(result)) {
-        return "";
+    if (is_stopword(m_term)) {
+        m_term.clear();
+        return;
     }
-    // stem the word
-    auto word_end = static_cast<size_t>(stem(&result[0], 0, result.size() - 1));
-    result = result.substr(0, word_end + 1);
-
-    return result;
+    // stem the word in place
+    m_stemmer.stem(m_term);
 }
 
 void ir::Tokenizer::normalize_all(std::vector<std::string>& token_vec) {
@@ -118,57 +176,136 @@ void ir::Tokenizer::normalize_all(std::vector<std::string>& token_vec) {
                     token_vec.end());
 }
 
+void ir::Tokenizer::count_term(TermStats& term_stats, std::string_view term) {
+    switch (m_stats_options.mode) {
+    case StatsMode::Exact:
+        m_key.assign(term.data(), term.size());
+        ++term_stats.counts[m_key];
+        break;
+    case StatsMode::Approximate:
+        term_stats.top_terms.add(term);
+        term_stats.term_count.add(term);
+        break;
+    default:
+        break;
+    }
+}
+
+void ir::Tokenizer::for_each_term(
+    std::string_view doc,
+    const std::function<void(std::string_view, uint32_t, size_t)>& callback) {
+    size_t position = 0;
+    size_t term_count = 0;
+    size_t pos = 0;
+    for (auto token = next_token(doc, pos); !token.empty();
+         token = next_token(doc, pos), ++position) {
+        count_term(unnormalized_terms, token);
+
+        uint32_t term_id;
+        const auto term = normalize_view(token, term_id);
+        // stopwords are dropped but keep their position
+        if (term.empty()) {
+            continue;
+        }
+        count_term(normalized_terms, term);
+        callback(term, term_id, position);
+        ++term_count;
+    }
+
+    m_stats.total_unnormalized_tokens += position;
+    m_stats.total_normalized_tokens += term_count;
+}
+
 std::vector<std::pair<std::string, size_t>>
 ir::Tokenizer::get_doc_terms(const raw_doc& doc) {
-    auto tokens_indices = tokenize(doc);
+    std::vector<std::pair<std::string, size_t>> terms;
+    get_doc_terms(doc, terms);
+    return terms;
+}
 
-    std::for_each(
-        tokens_indices.begin(), tokens_indices.end(),
-        [this](const auto& pair) { ++(this->unnormalized_terms[pair.first]); });
+void ir::Tokenizer::get_doc_terms(
+    std::string_view doc, std::vector<std::pair<std::string, size_t>>& terms) {
+    size_t term_count = 0;
+    for_each_term(doc, [&terms, &term_count](std::string_view term, uint32_t,
+                                             size_t position) {
+        if (term_count < terms.size()) {
+            terms[term_count].first.assign(term.data(), term.size());
+            terms[term_count].second = position;
+        } else {
+            terms.emplace_back(term, position);
+        }
+        ++term_count;
+    });
+    terms.resize(term_count);
+}
 
-    std::transform(
-        tokens_indices.begin(), tokens_indices.end(), tokens_indices.begin(),
-        [this](const auto& token_pair) -> std::pair<std::string, size_t> {
-            return {this->normalize(token_pair.first), token_pair.second};
-        });
+void ir::Tokenizer::get_doc_term_ids(
+    std::string_view doc, std::vector<std::pair<uint32_t, size_t>>& terms) {
+    assert(m_term_pool != nullptr);
+    terms.clear();
+    for_each_term(doc, [&terms](std::string_view, uint32_t term_id,
+                                size_t position) {
+        terms.emplace_back(term_id, position);
+    });
+}
 
-    tokens_indices.erase(std::remove_if(tokens_indices.begin(),
-                                        tokens_indices.end(),
-                                        [](const auto& token_pair) {
-                                            return token_pair.first.empty();
-                                        }),
-                         tokens_indices.end());
+void ir::Tokenizer::merge_stats(const Tokenizer& other) {
+    assert(m_stats_options.mode == other.m_stats_options.mode);
+    const std::pair<TermStats*, const TermStats*> stats_pairs[] = {
+        {&unnormalized_terms, &other.unnormalized_terms},
+        {&normalized_terms, &other.normalized_terms}};
+    for (const auto& stats_pair : stats_pairs) {
+        auto& term_stats = *stats_pair.first;
+        const auto& other_term_stats = *stats_pair.second;
+        for (const auto& pair : other_term_stats.counts) {
+            term_stats.counts[pair.first] += pair.second;
+        }
+        if (m_stats_options.mode == StatsMode::Approximate) {
+            term_stats.top_terms.merge(other_term_stats.top_terms);
+            term_stats.term_count.merge(other_term_stats.term_count);
+        }
+    }
 
-    std::for_each(
-        tokens_indices.begin(), tokens_indices.end(),
-        [this](const auto& pair) { ++(this->normalized_terms[pair.first]); });
+    const auto& other_stats = other.m_stats;
+    m_stats.total_unnormalized_tokens += other_stats.total_unnormalized_tokens;
+    m_stats.total_normalized_tokens += other_stats.total_normalized_tokens;
+    m_stats.cache_hits += other_stats.cache_hits;
+    m_stats.cache_misses += other_stats.cache_misses;
+}
 
-    m_stats.total_unnormalized_terms = unnormalized_terms.size();
-    m_stats.total_normalized_terms = normalized_terms.size();
-    m_stats.total_normalized_tokens += tokens_indices.size();
+void ir::Tokenizer::summarize(
+    const TermStats& term_stats, size_t& term_count,
+    std::array<std::string, Stats::TopTermCount>& top_terms) const {
+    std::vector<std::pair<std::string, size_t>> top;
+    switch (m_stats_options.mode) {
+    case StatsMode::Exact:
+        term_count = term_stats.counts.size();
+        top.assign(term_stats.counts.begin(), term_stats.counts.end());
+        std::sort(top.begin(), top.end(),
+                  [](const auto& left, const auto& right) {
+                      return left.second > right.second;
+                  });
+        break;
+    case StatsMode::Approximate:
+        term_count =
+            static_cast<size_t>(std::llround(term_stats.term_count.estimate()));
+        top = term_stats.top_terms.top(Stats::TopTermCount);
+        break;
+    default:
+        return;
+    }
 
-    return tokens_indices;
+    // fewer terms than Stats::TopTermCount may have been seen
+    for (size_t i = 0; i < Stats::TopTermCount && i < top.size(); ++i) {
+        top_terms[i] = top[i].first;
+    }
 }
 
 ir::Tokenizer::Stats ir::Tokenizer::stats() {
-    std::vector<std::pair<std::string, size_t>> unnormalized(
-        unnormalized_terms.begin(), unnormalized_terms.end());
-    std::vector<std::pair<std::string, size_t>> normalized(
-        normalized_terms.begin(), normalized_terms.end());
-
-    std::sort(unnormalized.begin(), unnormalized.end(),
-              [](const auto& left, const auto& right) {
-                  return left.second > right.second;
-              });
-    std::sort(normalized.begin(), normalized.end(),
-              [](const auto& left, const auto& right) {
-                  return left.second > right.second;
-              });
-
-    for (size_t i = 0; i < Stats::TopTermCount; ++i) {
-        m_stats.top_unnormalized_terms[i] = unnormalized[i].first;
-        m_stats.top_normalized_terms[i] = normalized[i].first;
-    }
+    summarize(unnormalized_terms, m_stats.total_unnormalized_terms,
+              m_stats.top_unnormalized_terms);
+    summarize(normalized_terms, m_stats.total_normalized_terms,
+              m_stats.top_normalized_terms);
 
     return m_stats;
 }